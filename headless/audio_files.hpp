@@ -0,0 +1,168 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Multichannel streams read from and written to WAV/CSV files by the offline tools.
+// Samples are interleaved ([frame * channels + channel]) and stored in volts:
+// audio files map full scale (1.0) to 10V like Rack's audio interface, CSV files hold volts.
+
+#define AUDIO_FILE_FULL_SCALE 10.f  // Voltage of the full scale sample
+
+struct Stream {
+	int channels = 0;
+	float sampleRate = 0.f;          // 0 if not known (CSV)
+	std::vector<float> samples;      // [frame * channels + channel], in volts
+
+	int64_t frames() const { return channels ? samples.size() / channels : 0; }
+};
+
+inline bool endsWith(const std::string& str, const std::string& suffix) {
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Reads a PCM (16, 24 or 32 bit) or IEEE float (32 bit) WAV file, returns an error message or an empty string
+inline std::string readWav(std::string path, Stream& stream) {
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file) return "could not open " + path;
+	std::vector<unsigned char> data;
+	unsigned char buffer[65536];
+	size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + read);
+	std::fclose(file);
+	auto u16 = [&](size_t i) { return (uint32_t) data[i] | ((uint32_t) data[i + 1] << 8); };
+	auto u32 = [&](size_t i) { return u16(i) | (u16(i + 2) << 16); };
+	if (data.size() < 12 || std::memcmp(&data[0], "RIFF", 4) || std::memcmp(&data[8], "WAVE", 4)) return path + " is not a WAV file";
+	int format = 0, bits = 0;
+	for (size_t i = 12; i + 8 <= data.size();) {
+		uint32_t size = u32(i + 4);
+		size_t chunk = i + 8;
+		if (!std::memcmp(&data[i], "fmt ", 4) && size >= 16) {
+			format = u16(chunk);
+			stream.channels = u16(chunk + 2);
+			stream.sampleRate = u32(chunk + 4);
+			bits = u16(chunk + 14);
+			// WAVE_FORMAT_EXTENSIBLE keeps the actual format in the sub-format GUID
+			if (format == 0xFFFE && size >= 26) format = u16(chunk + 24);
+		}
+		else if (!std::memcmp(&data[i], "data", 4)) {
+			if (!(format == 1 && (bits == 16 || bits == 24 || bits == 32)) && !(format == 3 && bits == 32)) return path + ": unsupported sample format";
+			if (stream.channels < 1) return path + ": no channels";
+			size_t bytes = bits / 8, count = std::min<size_t>(size, data.size() - chunk) / bytes;
+			count -= count % stream.channels;
+			stream.samples.resize(count);
+			for (size_t n = 0; n < count; n++) {
+				const unsigned char* p = &data[chunk + n * bytes];
+				float sample;
+				if (format == 3) std::memcpy(&sample, p, 4);
+				else if (bits == 16) sample = (int16_t) (p[0] | (p[1] << 8)) / 32768.f;
+				else if (bits == 24) sample = (int32_t) (((uint32_t) p[0] << 8) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 24)) / 2147483648.f;
+				else sample = (int32_t) (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24)) / 2147483648.f;
+				stream.samples[n] = AUDIO_FILE_FULL_SCALE * sample;
+			}
+			return "";
+		}
+		i = chunk + size + (size & 0x01);
+	}
+	return path + ": no audio data";
+}
+
+// Reads comma (or whitespace) separated values in volts, one frame per line.
+// Lines which do not start with a number (header, comments) are skipped.
+inline std::string readCsv(std::string path, Stream& stream) {
+	FILE* file = std::fopen(path.c_str(), "r");
+	if (!file) return "could not open " + path;
+	char line[4096];
+	while (std::fgets(line, sizeof(line), file)) {
+		std::vector<float> frame;
+		char* p = line;
+		while (true) {
+			while (*p == ',' || *p == ';' || *p == ' ' || *p == '\t') p++;
+			char* end;
+			float value = std::strtof(p, &end);
+			if (end == p) break;
+			frame.push_back(value);
+			p = end;
+		}
+		if (frame.empty()) continue;
+		if (!stream.channels) stream.channels = frame.size();
+		frame.resize(stream.channels, 0.f);
+		stream.samples.insert(stream.samples.end(), frame.begin(), frame.end());
+	}
+	std::fclose(file);
+	return stream.channels ? "" : path + ": no values";
+}
+
+// Reads a WAV or CSV file, depending on its extension
+inline std::string readStream(std::string path, Stream& stream) {
+	return endsWith(path, ".csv") ? readCsv(path, stream) : readWav(path, stream);
+}
+
+// Writes IEEE float WAV file incrementally, the header is completed by close()
+struct WavWriter {
+	FILE* file = nullptr;
+	int channels = 0;
+	int64_t frames = 0;
+	std::vector<float> buffer;
+
+	std::string open(std::string path, int channels, float sampleRate) {
+		file = std::fopen(path.c_str(), "wb");
+		if (!file) return "could not open " + path;
+		this->channels = channels;
+		writeHeader(sampleRate);
+		return "";
+	}
+	// Writes interleaved frames (in volts)
+	void write(const float* samples, int64_t count) {
+		buffer.resize(count * channels);
+		for (int64_t n = 0; n < count * channels; n++) buffer[n] = samples[n] / AUDIO_FILE_FULL_SCALE;
+		std::fwrite(buffer.data(), sizeof(float), buffer.size(), file);
+		frames += count;
+	}
+	void close(float sampleRate) {
+		if (!file) return;
+		std::fseek(file, 0, SEEK_SET);
+		writeHeader(sampleRate);
+		std::fclose(file);
+		file = nullptr;
+	}
+	void writeHeader(float sampleRate) {
+		uint32_t dataSize = frames * channels * sizeof(float), rate = sampleRate, byteRate = rate * channels * sizeof(float);
+		uint16_t format = 3, numChannels = channels, blockAlign = channels * sizeof(float), bits = 32;
+		uint32_t riffSize = 36 + dataSize, fmtSize = 16;
+		std::fwrite("RIFF", 1, 4, file);
+		writeLe(riffSize);
+		std::fwrite("WAVEfmt ", 1, 8, file);
+		writeLe(fmtSize);
+		writeLe(format);
+		writeLe(numChannels);
+		writeLe(rate);
+		writeLe(byteRate);
+		writeLe(blockAlign);
+		writeLe(bits);
+		std::fwrite("data", 1, 4, file);
+		writeLe(dataSize);
+	}
+	template <typename T>
+	void writeLe(T value) {
+		unsigned char bytes[sizeof(T)];
+		for (size_t i = 0; i < sizeof(T); i++) bytes[i] = (value >> (8 * i)) & 0xFF;
+		std::fwrite(bytes, 1, sizeof(T), file);
+	}
+};
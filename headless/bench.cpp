@@ -0,0 +1,124 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include "driver.hpp"
+
+// Headless benchmark: runs every module with synthetic inputs at several sample rates
+// and channel counts, reports the cost of a single process() call.
+//
+// Usage: bench [--seconds S] [--module SLUG] [--json FILE] [--sse]
+// (--sse runs the SSE kernels even if the CPU supports AVX2)
+
+struct Result {
+	std::string module;
+	float sampleRate;
+	int channels;
+	double nsPerSample;
+};
+
+// Runs the module (or only feeds the inputs) for a given number of frames, returns elapsed nanoseconds
+double run(Module* module, SyntheticInputs& inputs, float sampleRate, int64_t frames, bool process) {
+	Module::ProcessArgs args = {sampleRate, 1.f / sampleRate, 0};
+	auto start = std::chrono::steady_clock::now();
+	for (args.frame = 0; args.frame < frames; args.frame++) {
+		inputs.feed(module, args.frame);
+		if (process) module->process(args);
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+Result measure(Model* model, float sampleRate, int channels, float seconds) {
+	Module* module = createModule(model, sampleRate);
+	configureParams(module);
+	connectPorts(module, channels);
+	SyntheticInputs inputs;
+	inputs.generate(module->getNumInputs(), channels);
+	int64_t frames = seconds * sampleRate;
+	// Warm up (caches, branch predictors, module state)
+	run(module, inputs, sampleRate, frames / 10, true);
+	double total = run(module, inputs, sampleRate, frames, true);
+	// Cost of feeding the inputs is not a part of the module
+	double overhead = run(module, inputs, sampleRate, frames, false);
+	delete module;
+	return {model->slug, sampleRate, channels, (frames > 0) ? std::max(0.0, total - overhead) / frames : 0.0};
+}
+
+// Throughput as text, empty when the run is below the timer resolution (0 ns per sample)
+std::string samplesPerSecond(const Result& r) {
+	if (r.nsPerSample <= 0.0) return "";
+	char text[32];
+	std::snprintf(text, sizeof(text), "%.0f", 1e9 / r.nsPerSample);
+	return text;
+}
+
+void writeJson(std::string path, const std::vector<Result>& results) {
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) {
+		std::fprintf(stderr, "Could not open %s\n", path.c_str());
+		return;
+	}
+	std::fprintf(file, "{\n  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		// JSON has no infinity, an unknown rate is null
+		std::string throughput = samplesPerSecond(r);
+		std::fprintf(
+			file,
+			"    {\"module\": \"%s\", \"sampleRate\": %.0f, \"channels\": %d, \"nsPerSample\": %.3f, \"samplesPerSecond\": %s}%s\n",
+			r.module.c_str(), r.sampleRate, r.channels, r.nsPerSample, throughput.empty() ? "null" : throughput.c_str(), (i + 1 < results.size()) ? "," : ""
+		);
+	}
+	std::fprintf(file, "  ]\n}\n");
+	std::fclose(file);
+}
+
+int main(int argc, char* argv[]) {
+	float seconds = 2.f;
+	std::string jsonPath, filter;
+	bool sse = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) seconds = std::atof(argv[++i]);
+		else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+		else if (arg == "--module" && i + 1 < argc) filter = argv[++i];
+		else if (arg == "--sse") sse = true;
+		else {
+			std::fprintf(stderr, "Usage: %s [--seconds S] [--module SLUG] [--json FILE] [--sse]\n", argv[0]);
+			return 1;
+		}
+	}
+	Plugin plugin;
+	init(&plugin);
+	if (sse) instructionSet = INSTRUCTION_SET_SSE;
+	std::printf("Kernels: %s\n", (instructionSet == INSTRUCTION_SET_AVX2) ? "AVX2" : "SSE");
+	float sampleRates[4] = {44100.f, 48000.f, 96000.f, 192000.f};
+	int channelCounts[2] = {1, 16};
+	std::vector<Result> results;
+	std::printf("%-22s %8s %4s %12s %14s\n", "module", "rate", "ch", "ns/sample", "samples/sec");
+	for (Model* model : plugin.models) {
+		if (!filter.empty() && model->slug != filter) continue;
+		for (float sampleRate : sampleRates) {
+			for (int channels : channelCounts) {
+				Result r = measure(model, sampleRate, channels, seconds);
+				std::string throughput = samplesPerSecond(r);
+				std::printf("%-22s %8.0f %4d %12.2f %14s\n", r.module.c_str(), r.sampleRate, r.channels, r.nsPerSample, throughput.empty() ? "-" : throughput.c_str());
+				results.push_back(r);
+			}
+		}
+	}
+	if (!jsonPath.empty()) writeJson(jsonPath, results);
+	return 0;
+}
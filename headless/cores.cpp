@@ -0,0 +1,290 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include "driver.hpp"
+#include "../modules/ComparingCounter/ComparingCounterCore.hpp"
+#include "../modules/DigitalChaoticSystem/DigitalChaoticSystemCore.hpp"
+#include "../modules/DualIntegrator/DualIntegratorCore.hpp"
+#include "../modules/NonlinearIntegrator/NonlinearIntegratorCore.hpp"
+#include "../modules/VoltageSequencer/VoltageSequencerCore.hpp"
+#include "../modules/WindowGenerators/WindowGeneratorsCore.hpp"
+
+using simd::float_4;
+
+// Checks the scalar (float) instantiations of the modules' DSP cores against the SIMD (float_4) ones.
+// Every lane of a SIMD core and its own scalar core get the same synthetic inputs,
+// reports the maximum difference of all outputs over the run.
+// On CPUs with AVX2, whole modules running SSE and AVX2 kernels are compared the same way.
+// Event-driven modules are also checked to restore their outputs after being bypassed.
+//
+// Usage: cores [--seconds S] [--tolerance V]
+
+const float sampleRate = 48000.f, sampleTime = 1.f / sampleRate;
+
+// Each harness drives one core with inputs in[0..inputs) and collects its outputs
+template <typename T>
+struct ComparingCounterHarness {
+	static constexpr int inputs = 4, outputs = 3;
+	ComparingCounterCore<T> core;
+
+	void process(const T* in, int64_t, T* out) {
+		core.process(in[1], 0.5f * in[3], T(2.f));
+		out[0] = core.counter;
+		out[1] = core.compare;
+		out[2] = core.end;
+	}
+};
+
+template <typename T>
+struct DigitalChaoticSystemHarness {
+	static constexpr int inputs = 4, outputs = 7;
+	DigitalChaoticSystemCore<T> core;
+	DigitalChaoticSystemRegisters registers;
+
+	void process(const T* in, int64_t, T* out) {
+		T frequencies[2] = {core.frequency(5.f + in[1]), core.frequency(3.f + in[3])};
+		core.processOscillators(sampleTime, frequencies, true);
+		int clocked;
+		int data = core.registerInputs(core.naiveSquares[1], core.naiveSquares[0], clocked);
+		registers.clock(data, clocked);
+		core.processRegister(sampleTime, registers, 0);
+		for (unsigned char i = 0; i < 2; i++) {
+			out[i] = core.triangles[i];
+			out[2 + i] = core.squares[i];
+		}
+		out[4] = core.stepped;
+		out[5] = core.pulsed;
+		out[6] = core.smooth.lowpass();
+	}
+};
+
+template <typename T>
+struct DualIntegratorHarness {
+	static constexpr int inputs = 6, outputs = 4;
+	DualIntegratorCore<T> cells[2];             // T&H and S&H modes
+
+	void process(const T* in, int64_t, T* out) {
+		for (unsigned char i = 0; i < 2; i++) {
+			cells[i].process(sampleTime, in[1], in[2 + 2 * i], in[4 - 4 * i], cells[i].rate(0.5f * in[5]), i);
+			out[2 * i] = cells[i].output;
+			out[2 * i + 1] = cells[i].endOutput;
+		}
+	}
+};
+
+template <typename T>
+struct NonlinearIntegratorHarness {
+	static constexpr int inputs = 4, outputs = 8;
+	OversamplingKernel kernel;
+	NonlinearIntegratorCoefficients coefficients[2];
+	NonlinearIntegratorCore<T> cores[2];        // Chamberlin and zero-delay feedback engines
+
+	NonlinearIntegratorHarness() {
+		kernel.setFactor(2);
+		for (unsigned char i = 0; i < 2; i++) coefficients[i].build(i, sampleTime / kernel.factor);
+	}
+
+	void process(const T* in, int64_t, T* out) {
+		for (unsigned char i = 0; i < 2; i++) {
+			T f = coefficients[i].frequency(T(8.f) + in[1]);
+			T q = coefficients[i].resonance(T(5.f) + in[3]);
+			cores[i].process(sampleTime, coefficients[i], kernel, in[1], in[2], f, q);
+			for (unsigned char j = 0; j < 4; j++) out[4 * i + j] = cores[i].out[j];
+		}
+	}
+};
+
+template <typename T>
+struct VoltageSequencerHarness {
+	static constexpr int inputs = 10, outputs = 5;
+	VoltageSequencerCore<T> core;
+	float a[8] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 0.5f, 1.5f};
+	float b[8] = {5.f, 4.f, 3.f, 2.f, 1.f, 0.f, 4.5f, 3.5f};
+
+	void process(const T* in, int64_t frame, T* out) {
+		// Stage select every 7000 samples for 1000 samples, to the stage changing every 7 selects
+		bool selected = (frame % 7000) < 1000;
+		unsigned char preset = (frame / 49000) % 8;
+		if (core.process(in[0], in[2], in[6], in[4], in[8], in[5], selected, preset, 8.f) || !frame) core.gather(a, b);
+		out[0] = core.stage;
+		out[1] = core.aValues;
+		out[2] = core.bValues;
+		out[3] = core.allGates;
+		out[4] = ifelse(core.vStage, T(1.f), T(0.f));
+	}
+};
+
+template <typename T>
+struct WindowGeneratorsHarness {
+	static constexpr int inputs = 6, outputs = 10;
+	WindowGeneratorsCore<T> core;
+
+	void process(const T* in, int64_t, T* out) {
+		T times[4] = {in[1], 0.5f * in[3], -in[1], 0.2f * in[5]};
+		core.process(sampleTime, in[0], in[2], times, T(5.f) + 0.5f * in[3], T(0.f), 0.5f);
+		for (unsigned char i = 0; i < 4; i++) out[i] = core.envOuts[i];
+		for (unsigned char i = 0; i < 6; i++) out[4 + i] = core.gates[i];
+	}
+};
+
+// The same envelopes with the segment engine
+template <typename T>
+struct WindowGeneratorsSegmentsHarness {
+	static constexpr int inputs = 6, outputs = 10;
+	WindowGeneratorsCore<T> core;
+
+	void process(const T* in, int64_t, T* out) {
+		T times[4] = {in[1], 0.5f * in[3], -in[1], 0.2f * in[5]};
+		core.processSegments(sampleTime, in[0], in[2], times, T(5.f) + 0.5f * in[3], T(0.f), 0.5f);
+		for (unsigned char i = 0; i < 4; i++) out[i] = core.envOuts[i];
+		for (unsigned char i = 0; i < 6; i++) out[4 + i] = core.gates[i];
+	}
+};
+
+// Runs a SIMD harness and 4 scalar ones side by side, returns the maximum difference of outputs
+template <template <typename> class Harness>
+float compare(int64_t frames) {
+	const int inputs = Harness<float>::inputs, outputs = Harness<float>::outputs;
+	SyntheticInputs synthetic;
+	synthetic.generate(inputs, 4);
+	Harness<float_4> simd;
+	Harness<float> scalar[4];
+	float_4 simdIn[inputs], simdOut[outputs];
+	float scalarIn[inputs], scalarOut[outputs];
+	float worst = 0.f;
+	for (int64_t frame = 0; frame < frames; frame++) {
+		int n = frame % synthetic.blockLength;
+		for (int i = 0; i < inputs; i++) simdIn[i] = float_4::load(&synthetic.signals[i][n * 4]);
+		simd.process(simdIn, frame, simdOut);
+		for (int j = 0; j < 4; j++) {
+			for (int i = 0; i < inputs; i++) scalarIn[i] = simdIn[i][j];
+			scalar[j].process(scalarIn, frame, scalarOut);
+			for (int k = 0; k < outputs; k++) worst = std::max(worst, std::fabs(simdOut[k][j] - scalarOut[k]));
+		}
+	}
+	return worst;
+}
+
+// Runs a module with SSE and AVX2 kernels side by side (16 channels), returns the maximum difference of outputs
+float compareKernels(Model* model, int64_t frames) {
+	Module* modules[2];
+	InstructionSet instructionSets[2] = {INSTRUCTION_SET_SSE, INSTRUCTION_SET_AVX2};
+	for (int k = 0; k < 2; k++) {
+		instructionSet = instructionSets[k];
+		modules[k] = createModule(model, sampleRate);
+		configureParams(modules[k]);
+		connectPorts(modules[k], PORT_MAX_CHANNELS);
+	}
+	SyntheticInputs inputs;
+	inputs.generate(modules[0]->getNumInputs(), PORT_MAX_CHANNELS);
+	Module::ProcessArgs args = {sampleRate, sampleTime, 0};
+	float worst = 0.f;
+	for (args.frame = 0; args.frame < frames; args.frame++) {
+		for (int k = 0; k < 2; k++) {
+			inputs.feed(modules[k], args.frame);
+			modules[k]->process(args);
+		}
+		for (int i = 0; i < modules[0]->getNumOutputs(); i++) {
+			Output& sse = modules[0]->outputs[i];
+			Output& avx2 = modules[1]->outputs[i];
+			for (int c = 0; c < sse.channels; c++) worst = std::max(worst, std::fabs(sse.voltages[c] - avx2.voltages[c]));
+		}
+	}
+	for (int k = 0; k < 2; k++) delete modules[k];
+	return worst;
+}
+
+// Bypasses a module the way Rack does (outputs zeroed, mono), un-bypasses it and processes one more
+// sample with unchanged inputs (no clock edge). Returns the maximum difference from the outputs before bypassing,
+// event-driven modules have to write all of them again.
+float checkBypass(Model* model, int64_t frames) {
+	Module* module = createModule(model, sampleRate);
+	configureParams(module);
+	connectPorts(module, PORT_MAX_CHANNELS);
+	SyntheticInputs inputs;
+	inputs.generate(module->getNumInputs(), PORT_MAX_CHANNELS);
+	Module::ProcessArgs args = {sampleRate, sampleTime, 0};
+	for (args.frame = 0; args.frame < frames; args.frame++) {
+		inputs.feed(module, args.frame);
+		module->process(args);
+	}
+	std::vector<Output> before = module->outputs;
+	module->onBypass({});
+	// Zeroes all voltages, connected outputs keep 1 channel
+	for (Output& output : module->outputs) output.setChannels(0);
+	module->onUnBypass({});
+	module->process(args);
+	float worst = 0.f;
+	for (size_t i = 0; i < before.size(); i++) {
+		if (module->outputs[i].channels != before[i].channels) worst = INFINITY;
+		for (int c = 0; c < before[i].channels; c++) worst = std::max(worst, std::fabs(module->outputs[i].voltages[c] - before[i].voltages[c]));
+	}
+	delete module;
+	return worst;
+}
+
+int main(int argc, char* argv[]) {
+	float seconds = 10.f, tolerance = 1e-3f;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) seconds = std::atof(argv[++i]);
+		else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::atof(argv[++i]);
+		else {
+			std::fprintf(stderr, "Usage: %s [--seconds S] [--tolerance V]\n", argv[0]);
+			return 1;
+		}
+	}
+	int64_t frames = seconds * sampleRate;
+	struct Check {
+		std::string core;
+		float (*compare)(int64_t);
+	};
+	Check checks[7] = {
+		{"ComparingCounter", compare<ComparingCounterHarness>},
+		{"DigitalChaoticSystem", compare<DigitalChaoticSystemHarness>},
+		{"DualIntegrator", compare<DualIntegratorHarness>},
+		{"NonlinearIntegrator", compare<NonlinearIntegratorHarness>},
+		{"VoltageSequencer", compare<VoltageSequencerHarness>},
+		{"WindowGenerators", compare<WindowGeneratorsHarness>},
+		{"WindowGenerators/seg", compare<WindowGeneratorsSegmentsHarness>},
+	};
+	bool failed = false;
+	std::printf("%-22s %14s %8s\n", "core", "max diff (V)", "result");
+	for (const Check& check : checks) {
+		float difference = check.compare(frames);
+		bool passed = difference <= tolerance;
+		failed |= !passed;
+		std::printf("%-22s %14.3e %8s\n", check.core.c_str(), difference, passed ? "ok" : "FAILED");
+	}
+	Plugin plugin;
+	init(&plugin);
+	std::printf("\n%-22s %14s %8s\n", "bypass", "max diff (V)", "result");
+	{
+		float difference = checkBypass(findModel(plugin, "VoltageSequencer"), sampleRate);
+		bool passed = difference <= tolerance;
+		failed |= !passed;
+		std::printf("%-22s %14.3e %8s\n", "VoltageSequencer", difference, passed ? "ok" : "FAILED");
+	}
+	if (instructionSet == INSTRUCTION_SET_AVX2) {
+		std::printf("\n%-22s %14s %8s\n", "kernels (SSE/AVX2)", "max diff (V)", "result");
+		for (Model* model : plugin.models) {
+			float difference = compareKernels(model, frames);
+			bool passed = difference <= tolerance;
+			failed |= !passed;
+			std::printf("%-22s %14.3e %8s\n", model->slug.c_str(), difference, passed ? "ok" : "FAILED");
+		}
+	}
+	else std::printf("\nAVX2 kernels are not available, skipping SSE/AVX2 comparison\n");
+	return failed;
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+#include "../modules/plugin.hpp"
+
+// Helpers for driving the plugin's modules without Rack engine.
+
+// Finds a model registered by init() by its slug
+inline Model* findModel(Plugin& plugin, std::string slug) {
+	for (Model* model : plugin.models) {
+		if (model->slug == slug) return model;
+	}
+	return nullptr;
+}
+
+// Creates a module the same way Rack does when it is added to the patch
+inline Module* createModule(Model* model, float sampleRate) {
+	Module* module = model->createModule();
+	module->onSampleRateChange({sampleRate, 1.f / sampleRate});
+	return module;
+}
+
+// Puts all parameters in a deterministic state: default values, but all switches ON
+// (otherwise e.g. VoltageSequencer's clock would be disabled and the module would stay idle)
+inline void configureParams(Module* module) {
+	for (int i = 0; i < module->getNumParams(); i++) {
+		ParamQuantity* pq = module->paramQuantities[i];
+		if (!pq) continue;
+		module->params[i].setValue(pq->snapEnabled ? pq->maxValue : pq->defaultValue);
+	}
+}
+
+// Connects all ports, inputs with the given number of channels, outputs start as mono
+// (the modules set the number of output channels themselves)
+inline void connectPorts(Module* module, int channels) {
+	for (Input& input : module->inputs) input.channels = channels;
+	for (Output& output : module->outputs) output.channels = 1;
+}
+
+// Synthetic input signals, precomputed for a block of frames and played in a loop.
+// Even inputs get gates/clocks (0V/5V square waves), odd inputs get sine waves (-5V to 5V).
+// Each input uses a different number of cycles per block and each channel is slightly
+// detuned, so all channels follow their own state.
+struct SyntheticInputs {
+	int blockLength = 4096;
+	int channels = 1;
+	std::vector<std::vector<float>> signals;    // [input][frame * channels + channel]
+
+	void generate(int numInputs, int channels) {
+		this->channels = channels;
+		signals.assign(numInputs, std::vector<float>(blockLength * channels));
+		for (int i = 0; i < numInputs; i++) {
+			for (int c = 0; c < channels; c++) {
+				float cycles = (1 + (i >> 1)) * (1.f + c / 16.f);
+				for (int n = 0; n < blockLength; n++) {
+					float phase = cycles * n / blockLength;
+					phase -= std::floor(phase);
+					signals[i][n * channels + c] = (i & 0x01) ? 5.f * std::sin(2.f * (float) M_PI * phase) : 5.f * (phase < 0.5f);
+				}
+			}
+		}
+	}
+
+	void feed(Module* module, int64_t frame) {
+		int n = frame % blockLength;
+		for (size_t i = 0; i < signals.size(); i++) {
+			std::memcpy(module->inputs[i].voltages, &signals[i][n * channels], channels * sizeof(float));
+		}
+	}
+};
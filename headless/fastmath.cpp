@@ -0,0 +1,117 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include "driver.hpp"
+
+using simd::float_4;
+
+// Accuracy and speed of utils/fast_math.hpp against std:: (per lane, in double precision).
+// Reports the maximum error of the float_4 and float versions over the ranges used by the modules
+// and the cost of one float_4 call. Exits with 1 if an error exceeds the bound documented in fast_math.hpp.
+//
+// Usage: fastmath [--points N]
+
+float_4 stdExp2(float_4 x) { return {std::exp2(x[0]), std::exp2(x[1]), std::exp2(x[2]), std::exp2(x[3])}; }
+float_4 stdExp10(float_4 x) { return {std::pow(10.f, x[0]), std::pow(10.f, x[1]), std::pow(10.f, x[2]), std::pow(10.f, x[3])}; }
+float_4 stdLog2(float_4 x) { return {std::log2(x[0]), std::log2(x[1]), std::log2(x[2]), std::log2(x[3])}; }
+float_4 stdSin(float_4 x) { return {std::sin(x[0]), std::sin(x[1]), std::sin(x[2]), std::sin(x[3])}; }
+
+// Nanoseconds per float_4 call, arguments are kept within [xMin, xMax]
+// (the function is a template argument, so it gets inlined like in the modules)
+template <float_4 (*F)(float_4)>
+double speed(float xMin, float xMax) {
+	const int calls = 1 << 22;
+	float_4 x = xMin, step = (xMax - xMin) / calls, sum = 0.f;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < calls; i++) {
+		sum += F(x);
+		x += step;
+	}
+	auto end = std::chrono::steady_clock::now();
+	// Keep the result alive
+	if (sum[0] == 1.2345f) std::printf(" ");
+	return std::chrono::duration<double, std::nano>(end - start).count() / calls;
+}
+
+struct Range {
+	float xMin, xMax;
+	double bound;        // Maximum error documented in fast_math.hpp
+};
+
+struct Function {
+	std::string name;
+	float_4 (*fast)(float_4);
+	float (*scalar)(float);
+	double (*reference)(double);
+	bool relative;
+	Range ranges[3];     // Checked ranges, unused ones are empty
+	double (*fastSpeed)(float, float);
+	double (*stdSpeed)(float, float);
+};
+
+// Both the float_4 and the float versions are checked, they are separate instantiations
+double maxError(const Function& function, float xMin, float xMax, int points) {
+	double worst = 0.0;
+	for (int i = 0; i < points; i += 4) {
+		float_4 x;
+		for (int j = 0; j < 4; j++) x[j] = xMin + (xMax - xMin) * (i + j) / (points - 1);
+		float_4 y = function.fast(x);
+		for (int j = 0; j < 4; j++) {
+			double expected = function.reference(x[j]);
+			double error = std::max(std::fabs(y[j] - expected), std::fabs(function.scalar(x[j]) - expected));
+			if (function.relative) error /= std::fabs(expected);
+			worst = std::max(worst, error);
+		}
+	}
+	return worst;
+}
+
+int main(int argc, char* argv[]) {
+	int points = 1 << 20;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--points" && i + 1 < argc) points = std::atoi(argv[++i]);
+		else {
+			std::fprintf(stderr, "Usage: %s [--points N]\n", argv[0]);
+			return 1;
+		}
+	}
+	Function functions[4] = {
+		{"fastExp2", fastExp2, fastExp2, [](double x) { return std::exp2(x); }, true, {{-12.f, 20.f, 1.2e-7}, {-126.f, 126.f, 1.2e-7}, {}}, speed<fastExp2>, speed<stdExp2>},
+		{"fastExp10", fastExp10, fastExp10, [](double x) { return std::pow(10.0, x); }, true, {{-4.5f, 4.5f, 7e-7}, {}, {}}, speed<fastExp10>, speed<stdExp10>},
+		{"fastLog2", fastLog2, fastLog2, [](double x) { return std::log2(x); }, false, {{0.5f, 2.f, 1e-7}, {9.5367431640625e-7f, 1048576.f, 1.1e-6}, {}}, speed<fastLog2>, speed<stdLog2>},
+		{"fastSin", fastSin, fastSin, [](double x) { return std::sin(x); }, false, {{(float) -M_PI, (float) M_PI, 2e-7}, {-100.f, 100.f, 6e-6}, {}}, speed<fastSin>, speed<stdSin>},
+	};
+	bool failed = false;
+	std::printf("%-10s %20s %10s %10s %12s %12s  %s\n", "function", "range", "error", "bound", "ns/float_4", "std ns", "result");
+	for (int k = 0; k < 4; k++) {
+		const Function& function = functions[k];
+		for (int r = 0; r < 3; r++) {
+			const Range& range = function.ranges[r];
+			if (range.xMin == range.xMax) continue;
+			char name[32];
+			std::snprintf(name, sizeof(name), "[%g, %g]", range.xMin, range.xMax);
+			double error = maxError(function, range.xMin, range.xMax, points);
+			bool ok = (error <= range.bound);
+			failed |= !ok;
+			std::printf(
+				"%-10s %20s %10.2e %10.1e %12.2f %12.2f  %s\n",
+				function.name.c_str(), name, error, range.bound,
+				function.fastSpeed(range.xMin, range.xMax), function.stdSpeed(range.xMin, range.xMax), ok ? "ok" : "FAIL"
+			);
+		}
+	}
+	return failed ? 1 : 0;
+}
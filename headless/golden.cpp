@@ -0,0 +1,147 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include <dirent.h>
+#include "graph.hpp"
+
+// Golden reference test: renders every scenario graph of a directory (golden/*.graph) and compares
+// the outputs with the reference WAV file stored next to it (golden/NAME.wav). Any sample further
+// than the tolerance from the reference fails the run, so DSP changes that alter the sound of
+// a module are caught. References are (re)written with --update after an intended change.
+//
+// Usage: golden [DIR] [--update] [--tolerance VOLTS] [--seconds S]
+//
+// Scenarios run at 48 kHz, the global random state is reset before each of them, so modules seeding
+// their generators from it (NonlinearIntegrator) render the same noise every time.
+
+#define GOLDEN_SAMPLE_RATE 48000.f
+
+struct Scenario {
+	std::string name;
+	int taps = 0;
+	int64_t frames = 0;
+	std::vector<float> samples;      // [frame * taps + tap], in volts
+};
+
+// Lists the graph files of a directory, sorted by name
+std::vector<std::string> listGraphs(std::string directory) {
+	std::vector<std::string> names;
+	DIR* dir = opendir(directory.c_str());
+	if (!dir) return names;
+	while (dirent* entry = readdir(dir)) {
+		std::string name = entry->d_name;
+		if (endsWith(name, ".graph")) names.push_back(name.substr(0, name.size() - 6));
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+// Renders a scenario, returns an error message
+std::string render(Plugin& plugin, std::string path, int64_t frames, Scenario& scenario) {
+	random::init();
+	Graph graph;
+	std::string error = graph.load(plugin, GOLDEN_SAMPLE_RATE, path);
+	if (!error.empty()) return error;
+	scenario.taps = graph.taps.size();
+	scenario.frames = frames;
+	scenario.samples.resize(frames * scenario.taps);
+	Module::ProcessArgs args = {GOLDEN_SAMPLE_RATE, 1.f / GOLDEN_SAMPLE_RATE, 0};
+	for (; args.frame < frames; args.frame++) {
+		graph.step(args, false);
+		for (int i = 0; i < scenario.taps; i++) scenario.samples[args.frame * scenario.taps + i] = graph.taps[i].output->voltages[graph.taps[i].channel];
+	}
+	return "";
+}
+
+int main(int argc, char* argv[]) {
+	std::string directory = "golden";
+	float tolerance = 1e-3f, seconds = 0.125f;
+	bool update = false, usage = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--update") update = true;
+		else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::atof(argv[++i]);
+		else if (arg == "--seconds" && i + 1 < argc) seconds = std::atof(argv[++i]);
+		else if (arg[0] != '-') directory = arg;
+		else usage = true;
+	}
+	int64_t frames = seconds * GOLDEN_SAMPLE_RATE;
+	if (usage || frames <= 0 || !(tolerance >= 0.f)) {
+		std::fprintf(stderr, "Usage: %s [DIR] [--update] [--tolerance VOLTS] [--seconds S]\n", argv[0]);
+		return 1;
+	}
+	std::vector<std::string> names = listGraphs(directory);
+	if (names.empty()) {
+		std::fprintf(stderr, "No scenarios (*.graph) in %s\n", directory.c_str());
+		return 1;
+	}
+	Plugin plugin;
+	init(&plugin);
+
+	int failed = 0;
+	std::printf("%-36s %5s %12s  %s\n", "scenario", "taps", "max error", "result");
+	for (std::string& name : names) {
+		std::string graphPath = directory + "/" + name + ".graph", referencePath = directory + "/" + name + ".wav";
+		Scenario scenario;
+		std::string error = render(plugin, graphPath, frames, scenario);
+		if (!error.empty()) {
+			std::printf("%-36s %5s %12s  FAILED: %s\n", name.c_str(), "", "", error.c_str());
+			failed++;
+			continue;
+		}
+		if (update) {
+			WavWriter writer;
+			error = writer.open(referencePath, scenario.taps, GOLDEN_SAMPLE_RATE);
+			if (error.empty()) {
+				writer.write(scenario.samples.data(), scenario.frames);
+				writer.close(GOLDEN_SAMPLE_RATE);
+			}
+			std::printf("%-36s %5d %12s  %s\n", name.c_str(), scenario.taps, "", error.empty() ? "updated" : ("FAILED: " + error).c_str());
+			failed += !error.empty();
+			continue;
+		}
+		Stream reference;
+		error = readWav(referencePath, reference);
+		if (error.empty() && (reference.channels != scenario.taps || reference.frames() != scenario.frames)) {
+			error = "reference has " + std::to_string(reference.channels) + " outputs x " + std::to_string(reference.frames())
+				+ " frames, rendered " + std::to_string(scenario.taps) + " x " + std::to_string(scenario.frames);
+		}
+		if (!error.empty()) {
+			std::printf("%-36s %5d %12s  FAILED: %s\n", name.c_str(), scenario.taps, "", error.c_str());
+			failed++;
+			continue;
+		}
+		// The largest deviation and where it is (NaN counts as a failure)
+		float maxError = 0.f;
+		int64_t at = -1;
+		for (size_t n = 0; n < scenario.samples.size(); n++) {
+			float deviation = std::fabs(scenario.samples[n] - reference.samples[n]);
+			if (!(deviation <= maxError)) {
+				maxError = std::isnan(deviation) ? INFINITY : deviation;
+				at = n;
+				if (std::isnan(deviation)) break;
+			}
+		}
+		if (maxError <= tolerance) {
+			std::printf("%-36s %5d %12.3g  ok\n", name.c_str(), scenario.taps, maxError);
+			continue;
+		}
+		std::printf("%-36s %5d %12.3g  FAILED: output %d, frame %lld (%.6f V, expected %.6f V)\n", name.c_str(), scenario.taps, maxError,
+			(int) (at % scenario.taps), (long long) (at / scenario.taps), scenario.samples[at], reference.samples[at]);
+		failed++;
+	}
+	if (failed) std::printf("%d of %zu scenarios failed (tolerance %g V)\n", failed, names.size(), tolerance);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+#include <chrono>
+#include <sstream>
+#include "driver.hpp"
+#include "audio_files.hpp"
+
+// Graph of module instances, cables and stimuli run by the offline tools (render, golden).
+//
+// A graph file has one statement per line ('#' starts a comment):
+//   module NAME SLUG                  adds an instance of the module
+//   param NAME ID VALUE               sets a parameter
+//   data NAME KEY VALUE               sets a module setting (same key and value as in the patch file, e.g. engine 1),
+//                                     arrays are separated by commas (e.g. cycle true,false)
+//   cable NAME:OUTPUT NAME:INPUT      connects an output to an input (with one sample delay, as in Rack)
+//   input NAME:INPUT FILE             feeds the input from a WAV or CSV file (relative to the graph file),
+//                                     file channels become polyphonic channels
+//   signal NAME:INPUT WAVE HZ LOW HIGH [CHANNELS]
+//                                     feeds the input from a sine, square or saw wave between LOW and HIGH volts,
+//                                     channel c runs at HZ * (1 + c / 16)
+//   output NAME:OUTPUT[:CHANNEL]      adds a channel of the output (the first one by default) to the rendered file
+//   expander LEFT RIGHT               places the RIGHT module next to the LEFT one (expanders, cascades)
+// IDs are indices listed by render --list.
+
+struct Graph {
+	struct Instance {
+		std::string name, slug;
+		Module* module;
+		json_t* data;                // Settings passed to dataFromJson()
+		double ns = 0.0;             // Time spent in process() (with --profile)
+	};
+	struct Cable {
+		Output* output;
+		Input* input;
+	};
+	struct Feed {
+		Stream stream;
+		Input* input;
+	};
+	struct Tap {
+		Output* output;
+		int channel;
+	};
+	struct Signal {
+		Input* input;
+		std::string wave;
+		double frequency;
+		float low, high;
+	};
+	std::vector<Instance> instances;
+	std::vector<Cable> cables;
+	std::vector<Feed> feeds;
+	std::vector<Signal> signals;
+	std::vector<Tap> taps;
+	std::string directory;           // Directory of the graph file, input files are relative to it
+
+	~Graph() {
+		for (Instance& instance : instances) {
+			delete instance.module;
+			json_decref(instance.data);
+		}
+	}
+
+	Instance* find(std::string name) {
+		for (Instance& instance : instances) {
+			if (instance.name == name) return &instance;
+		}
+		return nullptr;
+	}
+
+	// Resolves NAME:PORT[:CHANNEL] to the module and the port ID (of inputs or outputs), returns an error message
+	std::string port(std::string ref, bool isInput, Module*& module, int& id, int* channel = nullptr) {
+		std::vector<std::string> parts;
+		std::stringstream refStream(ref);
+		std::string part;
+		while (std::getline(refStream, part, ':')) parts.push_back(part);
+		if (parts.size() < 2 || parts.size() > (channel ? 3u : 2u)) return "expected NAME:PORT" + std::string(channel ? "[:CHANNEL]" : "") + ", got " + ref;
+		Instance* instance = find(parts[0]);
+		if (!instance) return "unknown module " + parts[0];
+		module = instance->module;
+		id = std::atoi(parts[1].c_str());
+		if (id < 0 || id >= (isInput ? module->getNumInputs() : module->getNumOutputs())) return parts[0] + " has no " + (isInput ? "input " : "output ") + parts[1];
+		if (channel) {
+			*channel = (parts.size() > 2) ? std::atoi(parts[2].c_str()) : 0;
+			if (*channel < 0 || *channel >= PORT_MAX_CHANNELS) return "channel out of range in " + ref;
+		}
+		return "";
+	}
+
+	// Converts a setting value (integer, real, true/false, or an array of them separated by commas) to JSON
+	static json_t* jsonValue(std::string text) {
+		if (text.find(',') != std::string::npos) {
+			json_t* array = json_array();
+			std::stringstream items(text);
+			std::string item;
+			while (std::getline(items, item, ',')) json_array_append_new(array, jsonValue(item));
+			return array;
+		}
+		if (text == "true" || text == "false") return json_boolean(text == "true");
+		if (text.find_first_of(".eE") != std::string::npos) return json_real(std::atof(text.c_str()));
+		return json_integer(std::atoll(text.c_str()));
+	}
+
+	// Parses a single statement, returns an error message
+	std::string parse(Plugin& plugin, float sampleRate, std::vector<std::string> words) {
+		std::string command = words[0];
+		Module* module;
+		int id;
+		if (command == "module" && words.size() == 3) {
+			if (find(words[1])) return "duplicate module name " + words[1];
+			Model* model = findModel(plugin, words[2]);
+			if (!model) return "unknown module slug " + words[2];
+			Instance instance;
+			instance.name = words[1];
+			instance.slug = words[2];
+			instance.module = createModule(model, sampleRate);
+			instance.data = json_object();
+			instances.push_back(instance);
+			return "";
+		}
+		if ((command == "param" || command == "data") && words.size() == 4) {
+			Instance* instance = find(words[1]);
+			if (!instance) return "unknown module " + words[1];
+			if (command == "data") {
+				json_object_set_new(instance->data, words[2].c_str(), jsonValue(words[3]));
+				return "";
+			}
+			id = std::atoi(words[2].c_str());
+			if (id < 0 || id >= instance->module->getNumParams()) return words[1] + " has no parameter " + words[2];
+			instance->module->params[id].setValue(std::atof(words[3].c_str()));
+			return "";
+		}
+		if (command == "cable" && words.size() == 3) {
+			Cable cable;
+			std::string error = port(words[1], false, module, id);
+			if (!error.empty()) return error;
+			cable.output = &module->outputs[id];
+			error = port(words[2], true, module, id);
+			if (!error.empty()) return error;
+			cable.input = &module->inputs[id];
+			if (cable.input->isConnected()) return words[2] + " is already connected";
+			// Rack connects the ports as mono, modules set the number of output channels themselves
+			cable.output->channels = std::max<uint8_t>(cable.output->channels, 1);
+			cable.input->channels = 1;
+			cables.push_back(cable);
+			return "";
+		}
+		if (command == "input" && words.size() == 3) {
+			Feed feed;
+			std::string error = port(words[1], true, module, id);
+			if (error.empty()) error = readStream(words[2][0] == '/' ? words[2] : directory + words[2], feed.stream);
+			if (!error.empty()) return error;
+			feed.input = &module->inputs[id];
+			if (feed.input->isConnected()) return words[1] + " is already connected";
+			if (feed.stream.sampleRate && feed.stream.sampleRate != sampleRate) {
+				std::fprintf(stderr, "Warning: %s is %.0f Hz, played at %.0f Hz\n", words[2].c_str(), feed.stream.sampleRate, sampleRate);
+			}
+			feed.stream.channels = std::min(feed.stream.channels, (int) PORT_MAX_CHANNELS);
+			feed.input->channels = feed.stream.channels;
+			feeds.push_back(feed);
+			return "";
+		}
+		if (command == "signal" && (words.size() == 6 || words.size() == 7)) {
+			Signal signal;
+			std::string error = port(words[1], true, module, id);
+			if (!error.empty()) return error;
+			signal.input = &module->inputs[id];
+			if (signal.input->isConnected()) return words[1] + " is already connected";
+			signal.wave = words[2];
+			if (signal.wave != "sine" && signal.wave != "square" && signal.wave != "saw") return "unknown wave " + signal.wave + " (sine, square or saw)";
+			signal.frequency = std::atof(words[3].c_str());
+			signal.low = std::atof(words[4].c_str());
+			signal.high = std::atof(words[5].c_str());
+			int channels = (words.size() == 7) ? std::atoi(words[6].c_str()) : 1;
+			if (channels < 1 || channels > PORT_MAX_CHANNELS) return "channels out of range: " + words[6];
+			signal.input->channels = channels;
+			signals.push_back(signal);
+			return "";
+		}
+		if (command == "output" && words.size() == 2) {
+			Tap tap;
+			std::string error = port(words[1], false, module, id, &tap.channel);
+			if (!error.empty()) return error;
+			tap.output = &module->outputs[id];
+			tap.output->channels = std::max<uint8_t>(tap.output->channels, 1);
+			taps.push_back(tap);
+			return "";
+		}
+		if (command == "expander" && words.size() == 3) {
+			Instance* left = find(words[1]);
+			Instance* right = find(words[2]);
+			if (!left || !right) return "unknown module " + (left ? words[2] : words[1]);
+			left->module->rightExpander.module = right->module;
+			right->module->leftExpander.module = left->module;
+			left->module->onExpanderChange({1});
+			right->module->onExpanderChange({0});
+			return "";
+		}
+		return "unknown statement or wrong number of arguments: " + command;
+	}
+
+	std::string load(Plugin& plugin, float sampleRate, std::string path) {
+		directory = path.substr(0, path.find_last_of('/') + 1);
+		FILE* file = std::fopen(path.c_str(), "r");
+		if (!file) return "could not open " + path;
+		char line[4096];
+		int lineNumber = 0;
+		std::string error;
+		while (error.empty() && std::fgets(line, sizeof(line), file)) {
+			lineNumber++;
+			std::string text = line;
+			text = text.substr(0, text.find('#'));
+			std::stringstream words(text);
+			std::vector<std::string> statement;
+			std::string word;
+			while (words >> word) statement.push_back(word);
+			if (statement.empty()) continue;
+			error = parse(plugin, sampleRate, statement);
+			if (!error.empty()) error = path + ":" + std::to_string(lineNumber) + ": " + error;
+		}
+		std::fclose(file);
+		if (!error.empty()) return error;
+		if (instances.empty()) return path + ": no modules";
+		if (taps.empty()) return path + ": no outputs to render";
+		// Settings are loaded after all statements, like module data from a patch
+		for (Instance& instance : instances) {
+			if (!instance.data->obj.empty()) instance.module->dataFromJson(instance.data);
+		}
+		return "";
+	}
+
+	// Expander messages written in the previous frame become readable, like in Rack's engine
+	static void flipMessages(Module::Expander& expander) {
+		if (!expander.messageFlipRequested) return;
+		std::swap(expander.producerMessage, expander.consumerMessage);
+		expander.messageFlipRequested = false;
+	}
+
+	// Renders a single frame: moves voltages along the cables, from the input files and signals, then processes
+	// all modules (the same order as Rack's engine, so every cable delays the signal by one sample)
+	void step(Module::ProcessArgs& args, bool profile) {
+		for (Instance& instance : instances) {
+			flipMessages(instance.module->leftExpander);
+			flipMessages(instance.module->rightExpander);
+		}
+		for (Cable& cable : cables) {
+			cable.input->channels = cable.output->channels;
+			std::memcpy(cable.input->voltages, cable.output->voltages, cable.output->channels * sizeof(float));
+		}
+		for (Feed& feed : feeds) {
+			if (args.frame < feed.stream.frames()) std::memcpy(feed.input->voltages, &feed.stream.samples[args.frame * feed.stream.channels], feed.stream.channels * sizeof(float));
+			else std::memset(feed.input->voltages, 0, feed.stream.channels * sizeof(float));
+		}
+		for (Signal& signal : signals) {
+			for (int c = 0; c < signal.input->channels; c++) {
+				double cycles = signal.frequency * (1.0 + c / 16.0) * args.frame / args.sampleRate;
+				float phase = cycles - std::floor(cycles);
+				float unit = (signal.wave == "sine") ? 0.5f + 0.5f * std::sin(2.f * (float) M_PI * phase) : (signal.wave == "square") ? (phase < 0.5f) : phase;
+				signal.input->voltages[c] = signal.low + (signal.high - signal.low) * unit;
+			}
+		}
+		for (Instance& instance : instances) {
+			if (!profile) {
+				instance.module->process(args);
+				continue;
+			}
+			auto start = std::chrono::steady_clock::now();
+			instance.module->process(args);
+			instance.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+};
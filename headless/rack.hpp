@@ -0,0 +1,617 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+// Minimal stand-in for the Rack v2 SDK, used for building the modules headless
+// (benchmarks and offline tools). It provides only the API subset the plugin uses:
+// engine (Module, ports, params, lights), simd::float_4, dsp helpers, random,
+// a tiny jansson replacement and no-op widgets, so that the module sources
+// compile unchanged. Nothing here is shipped with the plugin.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <initializer_list>
+#include <immintrin.h>
+
+// ---- minimal jansson ----
+struct json_t {
+	enum Kind { OBJ, INT, REAL, BOOL, STR, ARR } kind = OBJ;
+	long long i = 0;
+	double r = 0;
+	std::string s;
+	std::map<std::string, json_t*> obj;
+	std::vector<json_t*> arr;
+};
+inline json_t* json_object() { return new json_t; }
+inline json_t* json_array() { json_t* j = new json_t; j->kind = json_t::ARR; return j; }
+inline json_t* json_integer(long long v) { json_t* j = new json_t; j->kind = json_t::INT; j->i = v; return j; }
+inline json_t* json_real(double v) { json_t* j = new json_t; j->kind = json_t::REAL; j->r = v; return j; }
+inline json_t* json_boolean(bool v) { json_t* j = new json_t; j->kind = json_t::BOOL; j->i = v; return j; }
+inline json_t* json_string(const char* v) { json_t* j = new json_t; j->kind = json_t::STR; j->s = v; return j; }
+inline int json_object_set_new(json_t* o, const char* k, json_t* v) { o->obj[k] = v; return 0; }
+inline int json_array_append_new(json_t* a, json_t* v) { a->arr.push_back(v); return 0; }
+inline json_t* json_object_get(const json_t* o, const char* k) { if (!o) return nullptr; auto it = o->obj.find(k); return it == o->obj.end() ? nullptr : it->second; }
+inline long long json_integer_value(const json_t* j) { return j ? j->i : 0; }
+inline double json_real_value(const json_t* j) { return j ? j->r : 0; }
+inline double json_number_value(const json_t* j) { return j ? (j->kind == json_t::REAL ? j->r : j->i) : 0; }
+inline bool json_is_true(const json_t* j) { return j && j->kind == json_t::BOOL && j->i; }
+inline bool json_boolean_value(const json_t* j) { return json_is_true(j); }
+inline const char* json_string_value(const json_t* j) { return j ? j->s.c_str() : nullptr; }
+inline size_t json_array_size(const json_t* a) { return a ? a->arr.size() : 0; }
+inline json_t* json_array_get(const json_t* a, size_t i) { return (a && i < a->arr.size()) ? a->arr[i] : nullptr; }
+inline void json_decref(json_t* j) {
+	if (!j) return;
+	for (auto& kv : j->obj) json_decref(kv.second);
+	for (json_t* v : j->arr) json_decref(v);
+	delete j;
+}
+
+namespace rack {
+
+// ---- math ----
+namespace math {
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+inline float crossfade(float a, float b, float p) { return a + (b - a) * p; }
+inline bool isNear(float a, float b, float epsilon = 1e-6f) { return std::fabs(a - b) <= epsilon; }
+inline int eucMod(int a, int b) { int m = a % b; return m < 0 ? m + b : m; }
+struct Vec {
+	float x = 0.f, y = 0.f;
+	Vec() {}
+	Vec(float x, float y) : x(x), y(y) {}
+	Vec plus(Vec b) const { return Vec(x + b.x, y + b.y); }
+};
+struct Rect { Vec pos, size; };
+}
+using namespace math;
+
+// ---- simd ----
+namespace simd {
+template <typename T, int N> struct Vector;
+
+template <> struct Vector<int32_t, 4>;
+
+template <>
+struct Vector<float, 4> {
+	using type = float;
+	constexpr static int size = 4;
+	union { __m128 v; float s[4]; };
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) { v = _mm_set1_ps(x); }
+	Vector(float x1, float x2, float x3, float x4) { v = _mm_setr_ps(x1, x2, x3, x4); }
+	explicit Vector(Vector<int32_t, 4> a);
+	static Vector zero() { return Vector(_mm_setzero_ps()); }
+	static Vector mask() { return Vector(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_setzero_si128(), _mm_setzero_si128()))); }
+	static Vector load(const float* x) { return Vector(_mm_loadu_ps(x)); }
+	void store(float* x) { _mm_storeu_ps(x, v); }
+	static Vector cast(Vector<int32_t, 4> a);
+	float& operator[](int i) { return s[i]; }
+	const float& operator[](int i) const { return s[i]; }
+};
+
+template <>
+struct Vector<int32_t, 4> {
+	using type = int32_t;
+	constexpr static int size = 4;
+	union { __m128i v; int32_t s[4]; };
+	Vector() = default;
+	Vector(__m128i v) : v(v) {}
+	Vector(int32_t x) { v = _mm_set1_epi32(x); }
+	Vector(int32_t x1, int32_t x2, int32_t x3, int32_t x4) { v = _mm_setr_epi32(x1, x2, x3, x4); }
+	explicit Vector(Vector<float, 4> a) { v = _mm_cvttps_epi32(a.v); }
+	static Vector zero() { return Vector(_mm_setzero_si128()); }
+	static Vector mask() { return Vector(_mm_cmpeq_epi32(_mm_setzero_si128(), _mm_setzero_si128())); }
+	static Vector load(const int32_t* x) { return Vector(_mm_loadu_si128((const __m128i*) x)); }
+	void store(int32_t* x) { _mm_storeu_si128((__m128i*) x, v); }
+	static Vector cast(Vector<float, 4> a) { return Vector(_mm_castps_si128(a.v)); }
+	int32_t& operator[](int i) { return s[i]; }
+	const int32_t& operator[](int i) const { return s[i]; }
+};
+
+inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) { v = _mm_cvtepi32_ps(a.v); }
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) { return Vector(_mm_castsi128_ps(a.v)); }
+
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+#define F4_BINOP(op, fn) \
+	inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); }
+F4_BINOP(+, _mm_add_ps)
+F4_BINOP(-, _mm_sub_ps)
+F4_BINOP(*, _mm_mul_ps)
+F4_BINOP(/, _mm_div_ps)
+F4_BINOP(&, _mm_and_ps)
+F4_BINOP(|, _mm_or_ps)
+F4_BINOP(^, _mm_xor_ps)
+F4_BINOP(==, _mm_cmpeq_ps)
+F4_BINOP(>=, _mm_cmpge_ps)
+F4_BINOP(>, _mm_cmpgt_ps)
+F4_BINOP(<=, _mm_cmple_ps)
+F4_BINOP(<, _mm_cmplt_ps)
+F4_BINOP(!=, _mm_cmpneq_ps)
+#undef F4_BINOP
+inline float_4 operator+(const float_4& a, float b) { return a + float_4(b); }
+inline float_4 operator-(const float_4& a, float b) { return a - float_4(b); }
+inline float_4 operator*(const float_4& a, float b) { return a * float_4(b); }
+inline float_4 operator/(const float_4& a, float b) { return a / float_4(b); }
+inline float_4 operator+(float a, const float_4& b) { return float_4(a) + b; }
+inline float_4 operator-(float a, const float_4& b) { return float_4(a) - b; }
+inline float_4 operator*(float a, const float_4& b) { return float_4(a) * b; }
+inline float_4 operator/(float a, const float_4& b) { return float_4(a) / b; }
+inline float_4 operator>=(const float_4& a, float b) { return a >= float_4(b); }
+inline float_4 operator>(const float_4& a, float b) { return a > float_4(b); }
+inline float_4 operator<=(const float_4& a, float b) { return a <= float_4(b); }
+inline float_4 operator<(const float_4& a, float b) { return a < float_4(b); }
+inline float_4 operator==(const float_4& a, float b) { return a == float_4(b); }
+inline float_4 operator!=(const float_4& a, float b) { return a != float_4(b); }
+inline float_4 operator&(const float_4& a, float b) { return a & float_4(b); }
+inline float_4& operator+=(float_4& a, const float_4& b) { return a = a + b; }
+inline float_4& operator-=(float_4& a, const float_4& b) { return a = a - b; }
+inline float_4& operator*=(float_4& a, const float_4& b) { return a = a * b; }
+inline float_4& operator/=(float_4& a, const float_4& b) { return a = a / b; }
+inline float_4& operator&=(float_4& a, const float_4& b) { return a = a & b; }
+inline float_4& operator|=(float_4& a, const float_4& b) { return a = a | b; }
+inline float_4& operator^=(float_4& a, const float_4& b) { return a = a ^ b; }
+inline float_4 operator-(const float_4& a) { return float_4(0.f) - a; }
+inline float_4 operator~(const float_4& a) { return a ^ float_4::mask(); }
+
+#define I4_BINOP(op, fn) \
+	inline int32_4 operator op(const int32_4& a, const int32_4& b) { return int32_4(fn(a.v, b.v)); }
+I4_BINOP(+, _mm_add_epi32)
+I4_BINOP(-, _mm_sub_epi32)
+I4_BINOP(&, _mm_and_si128)
+I4_BINOP(|, _mm_or_si128)
+I4_BINOP(^, _mm_xor_si128)
+I4_BINOP(==, _mm_cmpeq_epi32)
+I4_BINOP(>, _mm_cmpgt_epi32)
+I4_BINOP(<, _mm_cmplt_epi32)
+#undef I4_BINOP
+inline int32_4 operator*(const int32_4& a, const int32_4& b) { int32_4 r; for (int i = 0; i < 4; i++) r.s[i] = a.s[i] * b.s[i]; return r; }
+inline int32_4 operator<<(const int32_4& a, int b) { return int32_4(_mm_slli_epi32(a.v, b)); }
+inline int32_4 operator>>(const int32_4& a, int b) { return int32_4(_mm_srai_epi32(a.v, b)); }
+inline int32_4& operator+=(int32_4& a, const int32_4& b) { return a = a + b; }
+inline int32_4& operator-=(int32_4& a, const int32_4& b) { return a = a - b; }
+inline int32_4& operator&=(int32_4& a, const int32_4& b) { return a = a & b; }
+inline int32_4& operator|=(int32_4& a, const int32_4& b) { return a = a | b; }
+inline int32_4& operator^=(int32_4& a, const int32_4& b) { return a = a ^ b; }
+inline int32_4& operator<<=(int32_4& a, int b) { return a = a << b; }
+inline int32_4& operator>>=(int32_4& a, int b) { return a = a >> b; }
+inline int32_4 operator~(const int32_4& a) { return a ^ int32_4::mask(); }
+inline int32_4 operator-(const int32_4& a) { return int32_4(0) - a; }
+
+#define F4_MAP(name, fn) \
+	inline float_4 name(float_4 a) { float_4 r; for (int i = 0; i < 4; i++) r.s[i] = fn(a.s[i]); return r; }
+F4_MAP(sin, std::sin)
+F4_MAP(cos, std::cos)
+F4_MAP(exp, std::exp)
+F4_MAP(log, std::log)
+F4_MAP(tan, std::tan)
+F4_MAP(tanh, std::tanh)
+F4_MAP(atan, std::atan)
+F4_MAP(floor, std::floor)
+F4_MAP(ceil, std::ceil)
+F4_MAP(round, std::round)
+F4_MAP(trunc, std::trunc)
+F4_MAP(sqrt, std::sqrt)
+#undef F4_MAP
+inline float_4 log2(float_4 a) { float_4 r; for (int i = 0; i < 4; i++) r.s[i] = std::log2(a.s[i]); return r; }
+inline float_4 abs(float_4 a) { return float_4(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)); }
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_4 pow(float_4 a, float_4 b) { float_4 r; for (int i = 0; i < 4; i++) r.s[i] = std::pow(a.s[i], b.s[i]); return r; }
+inline float_4 pow(float a, float_4 b) { return pow(float_4(a), b); }
+inline float_4 pow(float_4 a, float b) { return pow(a, float_4(b)); }
+inline float_4 fmod(float_4 a, float_4 b) { float_4 r; for (int i = 0; i < 4; i++) r.s[i] = std::fmod(a.s[i], b.s[i]); return r; }
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return (a & mask) | float_4(_mm_andnot_ps(mask.v, b.v)); }
+inline int32_4 ifelse(int32_4 mask, int32_4 a, int32_4 b) { return (a & mask) | int32_4(_mm_andnot_si128(mask.v, b.v)); }
+inline float_4 sgn(float_4 x) { float_4 signbit = x & -0.f; float_4 nonzero = (x != 0.f); return signbit | (nonzero & 1.f); }
+inline int movemask(float_4 a) { return _mm_movemask_ps(a.v); }
+inline int movemask(int32_4 a) { return _mm_movemask_ps(_mm_castsi128_ps(a.v)); }
+inline float_4 rescale(float_4 x, float_4 xMin, float_4 xMax, float_4 yMin, float_4 yMax) { return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin); }
+inline float_4 crossfade(float_4 a, float_4 b, float_4 p) { return a + (b - a) * p; }
+
+inline float ifelse(bool cond, float a, float b) { return cond ? a : b; }
+inline float sgn(float x) { return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f); }
+using std::sin; using std::cos; using std::exp; using std::log; using std::pow; using std::floor; using std::trunc; using std::fmax; using std::fmin; using std::abs; using std::fmod; using std::sqrt; using std::tan; using std::tanh; using std::round; using std::log2;
+using math::clamp;
+inline int movemask(bool a) { return a; }
+} // namespace simd
+
+// ---- random ----
+// Fixed initial state, so generators seeded from it (see utils/prng.hpp) behave the same on every run,
+// init() restores it (the golden tool calls it before every scenario)
+namespace random {
+inline uint64_t& _state() { static uint64_t s = 0x853c49e6748fea9bULL; return s; }
+inline uint32_t u32() { uint64_t& x = _state(); x ^= x << 13; x ^= x >> 7; x ^= x << 17; return (uint32_t)(x >> 32); }
+inline uint64_t u64() { return ((uint64_t) u32() << 32) | u32(); }
+inline float uniform() { return (u32() >> 8) * 5.9604645e-8f; }
+inline float normal() { float u1 = uniform() + 1e-12f, u2 = uniform(); return std::sqrt(-2.f * std::log(u1)) * std::cos(2.f * (float) M_PI * u2); }
+inline void init() { _state() = 0x853c49e6748fea9bULL; }
+}
+
+// ---- dsp ----
+namespace dsp {
+template <typename T = float>
+struct TSchmittTrigger {
+	T state;
+	TSchmittTrigger() { reset(); }
+	void reset() { state = T::mask(); }
+	T process(T in, T lowThreshold = 0.f, T highThreshold = 1.f) {
+		T on = (in >= highThreshold);
+		T off = (in <= lowThreshold);
+		T triggered = ~state & on;
+		state = on | (state & ~off);
+		return triggered;
+	}
+	T isHigh() { return state; }
+};
+template <>
+struct TSchmittTrigger<float> {
+	bool state = true;
+	TSchmittTrigger() { reset(); }
+	void reset() { state = true; }
+	bool process(float in, float lowThreshold = 0.f, float highThreshold = 1.f) {
+		if (state) { if (in <= lowThreshold) state = false; }
+		else if (in >= highThreshold) { state = true; return true; }
+		return false;
+	}
+	bool isHigh() { return state; }
+};
+typedef TSchmittTrigger<> SchmittTrigger;
+
+template <typename T = float>
+struct TSlewLimiter {
+	T out = 0.f;
+	T rise = 0.f;
+	T fall = 0.f;
+	void reset() { out = 0.f; }
+	void setRiseFall(T rise, T fall) { this->rise = rise; this->fall = fall; }
+	T process(T deltaTime, T in) { out = simd::clamp(in, out - fall * deltaTime, out + rise * deltaTime); return out; }
+};
+typedef TSlewLimiter<> SlewLimiter;
+
+template <typename T = float>
+struct TRCFilter {
+	T c = 0.f;
+	T xstate[1];
+	T ystate[1];
+	TRCFilter() { reset(); }
+	void reset() { xstate[0] = 0.f; ystate[0] = 0.f; }
+	void setCutoff(T r) { c = 2.f / r; }
+	void setCutoffFreq(T f) { setCutoff(2.f * (float) M_PI * f); }
+	void process(T x) { T y = (x + xstate[0] - ystate[0] * (1 - c)) / (1 + c); xstate[0] = x; ystate[0] = y; }
+	T lowpass() { return ystate[0]; }
+	T highpass() { return xstate[0] - ystate[0]; }
+};
+typedef TRCFilter<> RCFilter;
+
+template <typename T = float>
+struct TPulseGenerator {
+	T remaining = 0.f;
+	void reset() { remaining = 0.f; }
+	T process(float deltaTime) { T mask = (remaining > 0.f); remaining -= ifelse(mask, deltaTime, 0.f); return ifelse(mask, 1.f, 0.f); }
+	void trigger(T duration = 1e-3f) { remaining = ifelse(duration > remaining, duration, remaining); }
+};
+template <>
+struct TPulseGenerator<float> {
+	float remaining = 0.f;
+	void reset() { remaining = 0.f; }
+	bool process(float deltaTime) { if (remaining > 0.f) { remaining -= deltaTime; return true; } return false; }
+	void trigger(float duration = 1e-3f) { if (duration > remaining) remaining = duration; }
+};
+typedef TPulseGenerator<> PulseGenerator;
+
+struct ClockDivider {
+	uint32_t clock = 0;
+	uint32_t division = 1;
+	void reset() { clock = 0; }
+	void setDivision(uint32_t d) { division = d; }
+	uint32_t getDivision() { return division; }
+	uint32_t getClock() { return clock; }
+	bool process() { clock++; if (clock >= division) { clock = 0; return true; } return false; }
+};
+}
+
+// ---- engine ----
+struct Model;
+namespace engine {
+static const int PORT_MAX_CHANNELS = 16;
+struct ParamQuantity {
+	std::string name, unit, description;
+	float minValue = 0.f, maxValue = 1.f, defaultValue = 0.f;
+	bool snapEnabled = false, randomizeEnabled = true;
+	std::vector<std::string> labels;
+};
+struct PortInfo { std::string name, description; };
+struct LightInfo { std::string name; };
+struct Param {
+	float value = 0.f;
+	float getValue() { return value; }
+	void setValue(float v) { value = v; }
+};
+struct Port {
+	union { float voltages[PORT_MAX_CHANNELS] = {}; float value; };
+	uint8_t channels = 0;
+	float getVoltage(int channel = 0) { return voltages[channel]; }
+	void setVoltage(float voltage, int channel = 0) { voltages[channel] = voltage; }
+	float getPolyVoltage(int channel) { return isMonophonic() ? getVoltage(0) : getVoltage(channel); }
+	float getNormalVoltage(float normalVoltage, int channel = 0) { return isConnected() ? getVoltage(channel) : normalVoltage; }
+	float getNormalPolyVoltage(float normalVoltage, int channel) { return isConnected() ? getPolyVoltage(channel) : normalVoltage; }
+	float* getVoltages(int firstChannel = 0) { return &voltages[firstChannel]; }
+	template <typename T> T getVoltageSimd(int firstChannel) { return T::load(&voltages[firstChannel]); }
+	template <typename T> T getPolyVoltageSimd(int firstChannel) { return isMonophonic() ? getVoltage(0) : getVoltageSimd<T>(firstChannel); }
+	template <typename T> T getNormalVoltageSimd(T normalVoltage, int firstChannel) { return isConnected() ? getVoltageSimd<T>(firstChannel) : normalVoltage; }
+	template <typename T> T getNormalPolyVoltageSimd(T normalVoltage, int firstChannel) { return isConnected() ? getPolyVoltageSimd<T>(firstChannel) : normalVoltage; }
+	template <typename T> void setVoltageSimd(T voltage, int firstChannel) { voltage.store(&voltages[firstChannel]); }
+	void setChannels(int channels) {
+		if (this->channels == 0) return;
+		for (int c = channels; c < this->channels; c++) voltages[c] = 0.f;
+		if (channels == 0) channels = 1;
+		this->channels = channels;
+	}
+	int getChannels() { return channels; }
+	bool isConnected() { return channels > 0; }
+	bool isMonophonic() { return channels == 1; }
+	bool isPolyphonic() { return channels > 1; }
+	void clearVoltages() { for (int c = 0; c < channels; c++) voltages[c] = 0.f; }
+};
+struct Input : Port {};
+struct Output : Port {};
+struct Light {
+	float value = 0.f;
+	void setBrightness(float b) { value = b; }
+	float getBrightness() { return value; }
+	void setBrightnessSmooth(float b, float deltaTime, float lambda = 30.f) {
+		if (b < value) value += (b - value) * lambda * deltaTime;
+		else value = b;
+	}
+};
+
+struct Module {
+	Model* model = nullptr;
+	int64_t id = -1;
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+	std::vector<PortInfo*> inputInfos, outputInfos;
+	struct Expander {
+		int64_t moduleId = -1;
+		Module* module = nullptr;
+		void* producerMessage = nullptr;
+		void* consumerMessage = nullptr;
+		bool messageFlipRequested = false;
+		void requestMessageFlip() { messageFlipRequested = true; }
+	};
+	Expander leftExpander, rightExpander;
+	bool bypassed = false;
+	struct ProcessArgs { float sampleRate; float sampleTime; int64_t frame; };
+	struct SampleRateChangeEvent { float sampleRate; float sampleTime; };
+	struct ResetEvent {};
+	struct RandomizeEvent {};
+	struct BypassEvent {};
+	struct UnBypassEvent {};
+	struct AddEvent {};
+	struct RemoveEvent {};
+	struct ExpanderChangeEvent { uint8_t side; };
+
+	virtual ~Module() {
+		for (ParamQuantity* pq : paramQuantities) delete pq;
+		for (PortInfo* info : inputInfos) delete info;
+		for (PortInfo* info : outputInfos) delete info;
+	}
+	void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+		params.resize(numParams);
+		inputs.resize(numInputs);
+		outputs.resize(numOutputs);
+		lights.resize(numLights);
+		paramQuantities.resize(numParams, nullptr);
+		inputInfos.resize(numInputs, nullptr);
+		outputInfos.resize(numOutputs, nullptr);
+	}
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+		TParamQuantity* q = new TParamQuantity;
+		q->name = name; q->unit = unit; q->minValue = minValue; q->maxValue = maxValue; q->defaultValue = defaultValue;
+		delete paramQuantities[paramId];
+		paramQuantities[paramId] = q;
+		params[paramId].value = defaultValue;
+		return q;
+	}
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {}) {
+		TParamQuantity* q = configParam<TParamQuantity>(paramId, minValue, maxValue, defaultValue, name);
+		q->snapEnabled = true; q->labels = labels;
+		return q;
+	}
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configButton(int paramId, std::string name = "") { return configParam<TParamQuantity>(paramId, 0.f, 1.f, 0.f, name); }
+	PortInfo* configInput(int portId, std::string name = "") { return configPort(inputInfos, portId, name); }
+	PortInfo* configOutput(int portId, std::string name = "") { return configPort(outputInfos, portId, name); }
+	PortInfo* configPort(std::vector<PortInfo*>& infos, int portId, std::string name) {
+		delete infos[portId];
+		infos[portId] = new PortInfo;
+		infos[portId]->name = name;
+		return infos[portId];
+	}
+	LightInfo* configLight(int, std::string = "") { static LightInfo l; return &l; }
+	void configBypass(int, int) {}
+	Param& getParam(int i) { return params[i]; }
+	Input& getInput(int i) { return inputs[i]; }
+	Output& getOutput(int i) { return outputs[i]; }
+	Light& getLight(int i) { return lights[i]; }
+	int getNumParams() { return params.size(); }
+	int getNumInputs() { return inputs.size(); }
+	int getNumOutputs() { return outputs.size(); }
+	int getNumLights() { return lights.size(); }
+	bool isBypassed() { return bypassed; }
+	virtual void process(const ProcessArgs& args) {}
+	virtual json_t* dataToJson() { return nullptr; }
+	virtual void dataFromJson(json_t* rootJ) {}
+	virtual void onSampleRateChange(const SampleRateChangeEvent& e) {}
+	virtual void onReset(const ResetEvent& e) {}
+	virtual void onRandomize(const RandomizeEvent& e) {}
+	virtual void onBypass(const BypassEvent& e) {}
+	virtual void onUnBypass(const UnBypassEvent& e) {}
+	virtual void onAdd(const AddEvent& e) {}
+	virtual void onRemove(const RemoveEvent& e) {}
+	virtual void onExpanderChange(const ExpanderChangeEvent& e) {}
+};
+}
+using engine::Module;
+using engine::Param;
+using engine::Input;
+using engine::Output;
+using engine::Light;
+using engine::ParamQuantity;
+using engine::PORT_MAX_CHANNELS;
+
+// ---- ui / app (compile-only) ----
+namespace widget {
+struct Widget {
+	math::Rect box;
+	bool visible = true;
+	std::vector<Widget*> children;
+	virtual ~Widget() { for (Widget* w : children) delete w; }
+	void addChild(Widget* w) { children.push_back(w); }
+	virtual void step() {}
+};
+}
+namespace ui {
+struct MenuItem : widget::Widget { std::string text, rightText; };
+struct MenuLabel : MenuItem {};
+struct MenuSeparator : widget::Widget {};
+struct Menu : widget::Widget {};
+}
+using namespace widget;
+using namespace ui;
+inline MenuLabel* createMenuLabel(std::string text) { MenuLabel* l = new MenuLabel; l->text = text; return l; }
+inline MenuItem* createMenuItem(std::string text, std::string rightText = "", std::function<void()> action = nullptr, bool disabled = false, bool alwaysConsume = false) { MenuItem* m = new MenuItem; m->text = text; return m; }
+template <typename T>
+MenuItem* createBoolPtrMenuItem(std::string text, std::string rightText, T* ptr) { return createMenuItem(text, rightText); }
+inline MenuItem* createBoolMenuItem(std::string text, std::string rightText, std::function<bool()> getter, std::function<void(bool)> setter, bool disabled = false, bool alwaysConsume = false) { return createMenuItem(text, rightText); }
+inline MenuItem* createSubmenuItem(std::string text, std::string rightText, std::function<void(Menu*)> createMenu, bool disabled = false) { return createMenuItem(text, rightText); }
+template <typename T>
+MenuItem* createIndexPtrSubmenuItem(std::string text, std::vector<std::string> labels, T* ptr) { return createMenuItem(text); }
+inline MenuItem* createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter, std::function<void(size_t)> setter, bool disabled = false, bool alwaysConsume = false) { return createMenuItem(text); }
+
+namespace app {
+struct SvgPanel : widget::Widget {};
+struct ParamWidget : widget::Widget {};
+struct PortWidget : widget::Widget {};
+struct LightWidget : widget::Widget {};
+struct ModuleWidget : widget::Widget {
+	engine::Module* module = nullptr;
+	virtual ~ModuleWidget() {}
+	void setModule(engine::Module* m) { module = m; }
+	engine::Module* getModule() { return module; }
+	template <class T> T* getModule() { return dynamic_cast<T*>(module); }
+	void setPanel(widget::Widget* panel) { box.size = math::Vec(15.f * 16, 380.f); addChild(panel); }
+	void addParam(ParamWidget* w) { addChild(w); }
+	void addInput(PortWidget* w) { addChild(w); }
+	void addOutput(PortWidget* w) { addChild(w); }
+	virtual void appendContextMenu(ui::Menu* menu) {}
+};
+}
+using namespace app;
+
+struct Plugin;
+struct Model {
+	Plugin* plugin = nullptr;
+	std::string slug;
+	virtual ~Model() {}
+	virtual engine::Module* createModule() = 0;
+	virtual app::ModuleWidget* createModuleWidget(engine::Module* m) = 0;
+};
+struct Plugin {
+	std::vector<Model*> models;
+	void addModel(Model* m) { m->plugin = this; models.push_back(m); }
+};
+
+template <class TModule, class TModuleWidget>
+Model* createModel(std::string slug) {
+	struct TModel : Model {
+		engine::Module* createModule() override {
+			TModule* m = new TModule;
+			m->model = this;
+			return m;
+		}
+		app::ModuleWidget* createModuleWidget(engine::Module* m) override { return new TModuleWidget(dynamic_cast<TModule*>(m)); }
+	};
+	TModel* o = new TModel;
+	o->slug = slug;
+	return o;
+}
+
+static const float RACK_GRID_WIDTH = 15.f;
+static const float RACK_GRID_HEIGHT = 380.f;
+inline math::Vec mm2px(math::Vec mm) { return math::Vec(mm.x * 75.f / 25.4f, mm.y * 75.f / 25.4f); }
+namespace string {
+template <typename... Args>
+std::string f(const char* format, Args... args) {
+	char buffer[1024];
+	std::snprintf(buffer, sizeof(buffer), format, args...);
+	return buffer;
+}
+}
+namespace asset {
+inline std::string plugin(Plugin*, std::string path) { return path; }
+inline std::string user(std::string path) { return path; }
+}
+inline widget::Widget* createPanel(std::string) { return new app::SvgPanel; }
+template <class TWidget> TWidget* createWidget(math::Vec pos) { TWidget* w = new TWidget; w->box.pos = pos; return w; }
+template <class TParamWidget> TParamWidget* createParamCentered(math::Vec pos, engine::Module*, int) { return createWidget<TParamWidget>(pos); }
+template <class TPortWidget> TPortWidget* createInputCentered(math::Vec pos, engine::Module*, int) { return createWidget<TPortWidget>(pos); }
+template <class TPortWidget> TPortWidget* createOutputCentered(math::Vec pos, engine::Module*, int) { return createWidget<TPortWidget>(pos); }
+template <class TLightWidget> TLightWidget* createLightCentered(math::Vec pos, engine::Module*, int) { return createWidget<TLightWidget>(pos); }
+
+namespace componentlibrary {
+struct ScrewBlack : widget::Widget {};
+struct PJ301MPort : app::PortWidget {};
+struct RoundLargeBlackKnob : app::ParamWidget {};
+struct RoundBlackKnob : app::ParamWidget {};
+struct NKK : app::ParamWidget {};
+struct CKSS : app::ParamWidget {};
+struct CKD6 : app::ParamWidget {};
+struct GreenRedLight : app::LightWidget {};
+struct YellowLight : app::LightWidget {};
+struct RedLight : app::LightWidget {};
+struct WhiteLight : app::LightWidget {};
+struct GreenLight : app::LightWidget {};
+template <class T> struct LargeLight : T {};
+template <class T> struct MediumLight : T {};
+template <class T> struct SmallLight : T {};
+}
+using namespace componentlibrary;
+
+#define ENUMS(name, count) name, name##_LAST = name + (count) - 1
+
+} // namespace rack
+
+// Plugin entry point (defined in modules/plugin.cpp)
+extern "C" void init(rack::Plugin* plugin);
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
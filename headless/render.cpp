@@ -0,0 +1,135 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include "graph.hpp"
+
+// Offline renderer: runs a graph of modules headless in blocks, as fast as the CPU allows,
+// feeds inputs from WAV/CSV streams, writes chosen outputs to a WAV file and reports timing stats.
+//
+// Usage: render GRAPH [-o OUT.wav] [--rate HZ] [--seconds S] [--block FRAMES] [--profile]
+//        render --list [SLUG]
+// (--list prints parameters and ports of the modules, --profile measures every instance separately)
+//
+// GRAPH is a text file describing modules, cables and stimuli (see graph.hpp).
+// Without --seconds, the length of the longest input file is rendered.
+
+// Prints parameters and ports of a module (or of all modules)
+void list(Plugin& plugin, std::string slug) {
+	for (Model* model : plugin.models) {
+		if (!slug.empty() && model->slug != slug) continue;
+		Module* module = createModule(model, 48000.f);
+		std::printf("%s\n", model->slug.c_str());
+		for (int i = 0; i < module->getNumParams(); i++) {
+			ParamQuantity* pq = module->paramQuantities[i];
+			if (pq) std::printf("  param  %3d  %-32s %g to %g (default %g)\n", i, pq->name.c_str(), pq->minValue, pq->maxValue, pq->defaultValue);
+		}
+		for (int i = 0; i < module->getNumInputs(); i++) {
+			std::printf("  input  %3d  %s\n", i, module->inputInfos[i] ? module->inputInfos[i]->name.c_str() : "");
+		}
+		for (int i = 0; i < module->getNumOutputs(); i++) {
+			std::printf("  output %3d  %s\n", i, module->outputInfos[i] ? module->outputInfos[i]->name.c_str() : "");
+		}
+		delete module;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::string graphPath, outPath = "out.wav", listSlug;
+	float sampleRate = 48000.f, seconds = 0.f;
+	int blockSize = 256;
+	bool profile = false, listModules = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc) outPath = argv[++i];
+		else if (arg == "--rate" && i + 1 < argc) sampleRate = std::atof(argv[++i]);
+		else if (arg == "--seconds" && i + 1 < argc) seconds = std::atof(argv[++i]);
+		else if (arg == "--block" && i + 1 < argc) blockSize = std::max(1, std::atoi(argv[++i]));
+		else if (arg == "--profile") profile = true;
+		else if (arg == "--list") {
+			listModules = true;
+			if (i + 1 < argc) listSlug = argv[++i];
+		}
+		else if (graphPath.empty() && arg[0] != '-') graphPath = arg;
+		else {
+			graphPath.clear();
+			break;
+		}
+	}
+	Plugin plugin;
+	init(&plugin);
+	if (listModules) {
+		list(plugin, listSlug);
+		return 0;
+	}
+	if (graphPath.empty() || sampleRate <= 0.f) {
+		std::fprintf(stderr, "Usage: %s GRAPH [-o OUT.wav] [--rate HZ] [--seconds S] [--block FRAMES] [--profile]\n", argv[0]);
+		std::fprintf(stderr, "       %s --list [SLUG]\n", argv[0]);
+		return 1;
+	}
+	Graph graph;
+	std::string error = graph.load(plugin, sampleRate, graphPath);
+	if (!error.empty()) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	int64_t frames = seconds * sampleRate;
+	if (!seconds) {
+		for (Graph::Feed& feed : graph.feeds) frames = std::max(frames, feed.stream.frames());
+	}
+	if (frames <= 0) {
+		std::fprintf(stderr, "Nothing to render, use --seconds (or input files)\n");
+		return 1;
+	}
+	WavWriter writer;
+	error = writer.open(outPath, graph.taps.size(), sampleRate);
+	if (!error.empty()) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	std::vector<float> block(blockSize * graph.taps.size());
+	Module::ProcessArgs args = {sampleRate, 1.f / sampleRate, 0};
+	double renderNs = 0.0, maxBlockNs = 0.0;
+	int64_t blocks = 0;
+	while (args.frame < frames) {
+		int64_t blockFrames = std::min<int64_t>(blockSize, frames - args.frame);
+		auto start = std::chrono::steady_clock::now();
+		for (int64_t n = 0; n < blockFrames; n++, args.frame++) {
+			graph.step(args, profile);
+			for (size_t i = 0; i < graph.taps.size(); i++) block[n * graph.taps.size() + i] = graph.taps[i].output->voltages[graph.taps[i].channel];
+		}
+		double blockNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		renderNs += blockNs;
+		maxBlockNs = std::max(maxBlockNs, blockNs);
+		blocks++;
+		writer.write(block.data(), blockFrames);
+	}
+	writer.close(sampleRate);
+
+	// Timing stats (writing the file is not included)
+	double duration = frames / sampleRate, blockBudgetNs = 1e9 * blockSize / sampleRate;
+	std::printf("Rendered %.3f s (%lld frames, %zu modules) to %s\n", duration, (long long) frames, graph.instances.size(), outPath.c_str());
+	std::printf("Render time %.3f s, %.1fx real time, %.2f ns/frame\n", renderNs * 1e-9, 1e9 * duration / renderNs, renderNs / frames);
+	std::printf("Blocks of %d frames: mean %.2f us, max %.2f us (%.1f%% of the %.2f us real-time budget)\n",
+		blockSize, renderNs / blocks * 1e-3, maxBlockNs * 1e-3, 100.0 * maxBlockNs / blockBudgetNs, blockBudgetNs * 1e-3);
+	if (profile) {
+		std::printf("%-16s %-22s %12s %8s\n", "instance", "module", "ns/frame", "share");
+		double total = 0.0;
+		for (Graph::Instance& instance : graph.instances) total += instance.ns;
+		for (Graph::Instance& instance : graph.instances) {
+			std::printf("%-16s %-22s %12.2f %7.1f%%\n", instance.name.c_str(), instance.slug.c_str(), instance.ns / frames, 100.0 * instance.ns / total);
+		}
+	}
+	return 0;
+}
@@ -13,8 +13,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 #include "../plugin.hpp"
+#include "ComparingCounterCore.hpp"
 
-using dsp::TSchmittTrigger;
 using simd::float_4;
 
 struct ComparingCounter : Module {
@@ -41,12 +41,16 @@ struct ComparingCounter : Module {
 		LIGHTS_LEN
 	};
 
-	float increment = 1.f / 6.f;        // Whole tone voltage step
-	float topMax = increment * 31.f;    // Maximum counter value in Volts
-	float cmp;                          // Current comparator value
-	float counter;                      // Counter value
-	float_4 input;                      // Used for processing all inputs
-	TSchmittTrigger<float> trigger;     // Used for updating the counter on compare
+	float increment = 1.f / 6.f;            // Whole tone voltage step
+	float topMax = increment * 31.f;        // Maximum counter value in Volts
+	unsigned char channels = 1;             // Number of polyphonic channels
+	ComparingCounterCore<float_4> cores[4]; // Comparators and counters, 4 channels per SIMD group
+	ControlRate controlRate;                // Schedules knob-only computations
+	CpuProfiler cpuProfiler;                // Cost of process() (instrumented builds only)
+	ControlRateValue<> aLevel, threshold;   // Signal A attenuator and THRESHOLD knobs
+	ControlRateValue<> limit, limitAttv;    // Counter limit (already limited if not modulated) and its CV attenuverter
+	bool cascade = false;                   // Cascade from the Comparing Counter on the left (its END normalled to A)
+	bool cascades[2] = {};                  // cascade latched for even and odd frames (see cascaded())
 
 	ComparingCounter() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
@@ -62,22 +66,82 @@ struct ComparingCounter : Module {
 		configOutput(END_OUTPUT, "End Gate");
 	}
 
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "cascade", json_boolean(cascade));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* cascadeJ = json_object_get(rootJ, "cascade");
+		if (cascadeJ) cascade = json_boolean_value(cascadeJ);
+	}
+
+	// Returns true if this counter is processed by the Comparing Counter on the left in the frame.
+	// Both counters decide it from the cascade flag latched by this one in the previous frame,
+	// so they agree even when the flag is changed from the menu while the engine runs them in parallel.
+	bool cascaded(int64_t frame) {
+		Module* left = leftExpander.module;
+		return cascades[frame & 1] && left && left->model == modelComparingCounter && !left->isBypassed();
+	}
+
+	// Returns the counter on the right if it is cascaded from this one, otherwise nullptr
+	ComparingCounter* cascadedRight(int64_t frame) {
+		Module* right = rightExpander.module;
+		if (!right || right->model != modelComparingCounter || right->isBypassed()) return nullptr;
+		ComparingCounter* counter = static_cast<ComparingCounter*>(right);
+		return counter->cascades[frame & 1] ? counter : nullptr;
+	}
+
+	// The first counter of a cascade processes all counters on its right in the same pass, from left to right,
+	// so END of every counter reaches the next one within the same sample (cables and expander messages
+	// would delay it by a sample per counter). Cascaded counters skip their own processing.
 	void process(const ProcessArgs& args) override {
-		// y = (x * a) + b
-		input = {inputs[A_INPUT].getVoltage(), inputs[B_INPUT].getVoltage(), inputs[COUNT_CV_INPUT].getVoltage(), 0.f};
-		input *= {params[A_POT_PARAM].getValue(), 1.f, params[COUNT_CV_ATTV_PARAM].getValue(), 0.f};
-		input += {0.f, params[REFERENCE_PARAM].getValue(), params[COUNTER_LIMIT_PARAM].getValue(), 0.f};
-		// CMP = (k*A > B + THRESHOLD)
-		cmp = gateOn * (input[0] > input[1]);
-		// Update the counter
-		counter += increment * trigger.process(cmp, triggerThresholdLevel, triggerThresholdLevel);
-		// Reset counter if reached the limit
-		if (counter >= clamp(input[2], 0.f, topMax)) counter = 0.f;
-		// Output values
-		outputs[COMPARE_OUTPUT].setVoltage(cmp);
-		outputs[COUNTER_OUTPUT].setVoltage(counter);
-		// END is only high when counter is 0 and CMP is high
-		outputs[END_OUTPUT].setVoltage(gateOn * (trigger.isHigh() && !counter));
+		CpuProfiler::Scope profile(cpuProfiler);
+		cascades[(args.frame + 1) & 1] = cascade;
+		if (cascaded(args.frame)) return;
+		ComparingCounter* source = nullptr;
+		for (ComparingCounter* counter = this; counter; counter = counter->cascadedRight(args.frame)) {
+			counter->processCounters(source);
+			source = counter;
+		}
+	}
+
+	// Processes comparators and counters, END of the source counter (if any) is normalled to A input
+	void processCounters(ComparingCounter* source) {
+		bool normalled = source && !inputs[A_INPUT].isConnected();
+		channels = normalled ? source->channels : 1;
+		for (unsigned char i = 0; i < INPUTS_LEN; i++) channels = std::max(channels, (unsigned char) inputs[i].getChannels());
+		if (controlRate.process()) {
+			// Without CV the counter limit only depends on the knob, limit it here
+			bool modulated = inputs[COUNT_CV_INPUT].isConnected();
+			float countLimit = params[COUNTER_LIMIT_PARAM].getValue();
+			limit.setTarget(controlRate, modulated ? countLimit : clamp(countLimit, 0.f, topMax), modulated);
+			aLevel.setTarget(controlRate, params[A_POT_PARAM].getValue());
+			threshold.setTarget(controlRate, params[REFERENCE_PARAM].getValue());
+			limitAttv.setTarget(controlRate, params[COUNT_CV_ATTV_PARAM].getValue());
+		}
+		float aPot = aLevel.process(), reference = threshold.process();
+		float countAttv = limitAttv.process(), countLimit = limit.process();
+		for (unsigned char c = 0; c < channels; c += 4) {
+			unsigned char g = (c >> 2);
+			// y = (x * a) + b
+			float_4 a = inputs[A_INPUT].getPolyVoltageSimd<float_4>(c) * aPot;
+			if (normalled) {
+				// Lanes above the source's channels hold stale END gates, they are zeroed
+				float_4 end = (source->channels == 1) ? float_4(source->cores[0].end[0]) : ifelse(float_4(c, c + 1, c + 2, c + 3) < float(source->channels), source->cores[g].end, 0.f);
+				a = end * aPot;
+			}
+			float_4 b = inputs[B_INPUT].getPolyVoltageSimd<float_4>(c) + reference;
+			float_4 top = countLimit;
+			if (limit.modulated) top = clamp(inputs[COUNT_CV_INPUT].getPolyVoltageSimd<float_4>(c) * countAttv + countLimit, 0.f, topMax);
+			cores[g].process(a, b, top);
+			// Output values
+			outputs[COMPARE_OUTPUT].setVoltageSimd(cores[g].compare, c);
+			outputs[COUNTER_OUTPUT].setVoltageSimd(cores[g].counter, c);
+			outputs[END_OUTPUT].setVoltageSimd(cores[g].end, c);
+		}
+		for (unsigned char i = 0; i < OUTPUTS_LEN; i++) outputs[i].setChannels(channels);
 	}
 };
 
@@ -99,5 +163,12 @@ struct ComparingCounterWidget : ModuleWidget {
 		addInput(createInputCentered<PJ301MPort>(mm2px(Vec(xCoords(0), yCoords(2))), module, ComparingCounter::B_INPUT));
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(xCoords(1), yCoords(0))), module, ComparingCounter::COUNTER_OUTPUT));
 	}
+
+	void appendContextMenu(Menu* menu) override {
+		ComparingCounter* module = getModule<ComparingCounter>();
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createBoolPtrMenuItem("Cascade from the left Comparing Counter", "", &module->cascade));
+		appendCpuProfilerMenu(menu, module, module->cpuProfiler);
+	}
 };
 Model* modelComparingCounter = createModel<ComparingCounter, ComparingCounterWidget>("ComparingCounter");
\ No newline at end of file
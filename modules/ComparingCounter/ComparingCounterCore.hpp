@@ -0,0 +1,44 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef COMPARING_COUNTER_CORE_H
+#define COMPARING_COUNTER_CORE_H
+#include <rack.hpp>
+#include "../utils/lanes.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// Comparator and counter of ComparingCounter, independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct ComparingCounterCore {
+	typedef typename Lanes<T>::Mask Mask;
+	float increment = 1.f / 6.f;                // Whole tone voltage step
+	T counter = 0.f;                            // Counter values (COUNTER output)
+	rack::dsp::TSchmittTrigger<T> trigger;      // Used for updating the counters on compare
+	T compare = 0.f;                            // COMPARE output
+	T end = 0.f;                                // END output
+
+	// Compares scaled A with B (THRESHOLD already added), counts up to the (limited) top value
+	void process(T a, T b, T top) {
+		// CMP = (k*A > B + THRESHOLD)
+		compare = ifelse(a > b, gateOn, gateOff);
+		// Update the counter
+		counter += ifelse(trigger.process(compare, triggerThresholdLevel, triggerThresholdLevel), increment, 0.f);
+		// Reset counter if reached the limit
+		counter = ifelse(counter >= top, 0.f, counter);
+		// END is only high when counter is 0 and CMP is high
+		end = ifelse(Mask(trigger.isHigh() & (counter == 0.f)), gateOn, gateOff);
+	}
+};
+#endif // COMPARING_COUNTER_CORE_H
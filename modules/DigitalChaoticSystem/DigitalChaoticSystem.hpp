@@ -0,0 +1,113 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DIGITAL_CHAOTIC_SYSTEM_H
+#define DIGITAL_CHAOTIC_SYSTEM_H
+#include "../plugin.hpp"
+#include "DigitalChaoticSystemCore.hpp"
+
+struct DigitalChaoticSystem : Module {
+	enum ParamId {
+		ENUMS(RATE, 2),
+		ENUMS(CV_ATT, 4),
+		PARAMS_LEN
+	};
+	enum InputId {
+		ENUMS(CV, 4),
+		VOCT1_INPUT,
+		DATA_INPUT,
+		CLOCK_INPUT,
+		VOCT2_INPUT,
+		INPUTS_LEN
+	};
+	enum OutputId {
+		ENUMS(VCOS, 4),
+		STEPPED_OUTPUT,
+		PULSED_OUTPUT,
+		SMOOTHED_OUTPUT,
+		OUTPUTS_LEN
+	};
+	enum LightId {
+		LIGHTS_LEN
+	};
+
+	DigitalChaoticSystem() {
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		std::string vco[2] = {"Clock", "Data"};
+		std::string waveforms[2] = {"Triangle", "Square"};
+		for (unsigned char i = 0; i < 2; i++) {
+			std::string vcoName = vco[i] + " Oscillator";
+			configParam(i, -5.f, 15.f, 5.f, vcoName + " Frequency", "Hz", 2.f);
+			configInput(i ? VOCT2_INPUT : VOCT1_INPUT, vcoName + " V/Oct");
+			for (unsigned char j = 0; j < 2; j++) {
+				float min = -1.f * (i ^ j);
+				std::string att = min ? "Attenuverter" : "Attenuator";
+				unsigned char twoJPlusI = (j << 1) + i;
+				configInput(twoJPlusI, vcoName + " Frequency Modulation");
+				configParam(2 + twoJPlusI, min, 1.f, 0.f, vcoName + " " + att);
+				configOutput((i << 1) + j, vcoName + " " + waveforms[j]);
+			}
+		}
+		configInput(CLOCK_INPUT, "Clock Trigger (normalized to Clock VCO Square)");
+		configInput(DATA_INPUT, "Data Gate (normalized to Data VCO Square)");
+		configOutput(STEPPED_OUTPUT, "Stepped");
+		configOutput(PULSED_OUTPUT, "Pulsed");
+		configOutput(SMOOTHED_OUTPUT, "Smooth");	
+		simdKernel.reset(createSimdKernel<DigitalChaoticSystem>());
+	}
+
+
+	unsigned char channels = 1;         // Number of polyphonic channels
+	std::unique_ptr<SimdKernel<DigitalChaoticSystem>> simdKernel;  // VCOs and shift registers for the widest instruction set
+	bool bandLimited = false;           // Band-limited (PolyBLEP) waveforms on VCO outputs
+
+	ControlRate controlRate;            // Schedules knob-only computations
+	CpuProfiler cpuProfiler;            // Cost of process() (instrumented builds only)
+	ControlRateValue<> rates[2];        // RATE knobs (frequencies in Hertz if not modulated)
+	ControlRateValue<> attvs[4];        // CV attenuators
+	float rateNow[2] = {};              // Current values of rates and attvs, read by the kernel
+	float attvNow[4] = {};
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "bandLimited", json_boolean(bandLimited));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* bandLimitedJ = json_object_get(rootJ, "bandLimited");
+		if (bandLimitedJ) bandLimited = json_is_true(bandLimitedJ);
+	}
+
+	void process(const ProcessArgs& args) override {
+		CpuProfiler::Scope profile(cpuProfiler);
+		channels = 1;
+		for (unsigned char i = 0; i < INPUTS_LEN; i++) channels = std::max(channels, (unsigned char) inputs[i].getChannels());
+		if (controlRate.process()) {
+			for (unsigned char i = 0; i < 2; i++) {
+				// Without CVs the frequency only depends on the knob, convert it to Hertz here
+				bool modulated = inputs[CV + i].isConnected() || inputs[CV + 2 + i].isConnected() || inputs[i ? VOCT2_INPUT : VOCT1_INPUT].isConnected();
+				float rate = params[RATE + i].getValue();
+				rates[i].setTarget(controlRate, modulated ? rate : std::pow(2.f, clamp(rate, -5.f, 15.f)), modulated);
+			}
+			for (unsigned char i = 0; i < 4; i++) attvs[i].setTarget(controlRate, params[CV_ATT + i].getValue());
+		}
+		for (unsigned char i = 0; i < 2; i++) rateNow[i] = rates[i].process();
+		for (unsigned char i = 0; i < 4; i++) attvNow[i] = attvs[i].process();
+		simdKernel->process(*this, args);
+		for (unsigned char i = 0; i < OUTPUTS_LEN; i++) outputs[i].setChannels(channels);
+	}
+};
+
+#endif // DIGITAL_CHAOTIC_SYSTEM_H
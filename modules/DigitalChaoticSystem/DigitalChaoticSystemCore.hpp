@@ -0,0 +1,98 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DIGITAL_CHAOTIC_SYSTEM_CORE_H
+#define DIGITAL_CHAOTIC_SYSTEM_CORE_H
+#include <rack.hpp>
+#include "../utils/fast_math.hpp"
+#include "../utils/lanes.hpp"
+#include "../utils/polyblep.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// Shift registers of all channels of DigitalChaoticSystem, bit-sliced:
+// bit c of word k holds bit k of channel's c shift register.
+// This way clocking and XOR is done for all 16 channels at once.
+struct DigitalChaoticSystemRegisters {
+	uint16_t bits[8] = {};                      // Register positions, bit per channel
+	uint16_t xored = 0;                         // XOR(data, shift_register(8)) for all channels
+
+	// Shifts XOR(data, shift_register(8)) into the registers of channels with a clock rising edge
+	void clock(uint16_t data, uint16_t clocked) {
+		xored = data ^ bits[0];
+		for (unsigned char k = 0; k < 7; k++) bits[k] = (bits[k] & ~clocked) | (bits[k + 1] & clocked);
+		bits[7] = (bits[7] & ~clocked) | (xored & clocked);
+	}
+};
+
+// Two VCOs and the register outputs of DigitalChaoticSystem, independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct DigitalChaoticSystemCore {
+	T phases[2] = {};                           // VCOs phase state
+	T triangles[2] = {};                        // TRIANGLE waveforms
+	T squares[2] = {};                          // SQUARE waveforms (band-limited if enabled)
+	T naiveSquares[2] = {};                     // Naive SQUARE waveforms, used for shift register and input normalization
+	rack::dsp::TSchmittTrigger<T> clock;        // Clock trigger input processing
+	T stepped = 0.f;                            // STEPPED output
+	T pulsed = 0.f;                             // PULSED output
+	rack::dsp::TRCFilter<T> smooth;             // Used for generating smooth version of stepped signal
+
+	// Converts VCO pitch (RATE + CVs + V/OCT) to Hertz
+	static T frequency(T pitch) {
+		return fastExp2(clamp(pitch, -5.f, 15.f));
+	}
+
+	// Advances both VCOs, frequencies in Hertz
+	void processOscillators(float sampleTime, const T* frequencies, bool bandLimited) {
+		for (unsigned char i = 0; i < 2; i++) {
+			// Accumulate phases
+			T delta = frequencies[i] * sampleTime;
+			phases[i] += delta;
+			// Reset phases if needed
+			phases[i] += ifelse(phases[i] >= 0.5f, T(-1.f), T(0.f));
+			// Generate waveforms (TRIANGLE, SQUARE)
+			// The naive square is always used for shift register, so the clock edges are not affected
+			naiveSquares[i] = clamp(phases[i] * 1e5f, -gateOn, gateOn);
+			triangles[i] = clamp(20.f * (rack::simd::abs(phases[i]) - 0.25f), -gateOn, gateOn);
+			squares[i] = naiveSquares[i];
+			if (bandLimited) {
+				// Distances (in samples) to the phase zero crossing (rising edge, triangle minimum)
+				// and to the phase reset (falling edge, triangle maximum)
+				T toZero = phases[i] / delta;
+				T toReset = (phases[i] - ifelse(phases[i] < 0.f, T(-0.5f), T(0.5f))) / delta;
+				squares[i] += 2.f * gateOn * (polyBlep(toZero) - polyBlep(toReset));
+				triangles[i] += 40.f * delta * (polyBlamp(toZero) - polyBlamp(toReset));
+			}
+		}
+	}
+
+	// Returns data gates of the lanes (bit per lane) and sets their clock rising edges,
+	// data and clock are already normalized to the VCOs' squares
+	int registerInputs(T data, T clockInput, int& clocked) {
+		clocked = Lanes<T>::bits(clock.process(clockInput, triggerThresholdLevel, triggerThresholdLevel));
+		return Lanes<T>::bits(data > triggerThresholdLevel);
+	}
+
+	// Reads the outputs of the lanes' registers, starting at channel c, after they were clocked
+	void processRegister(float sampleTime, const DigitalChaoticSystemRegisters& registers, unsigned char c) {
+		// Calculate stepped function (last 3 bits from shift register as 8 state analog value)
+		stepped = Lanes<T>::fromBits(registers.bits[0] >> c) + 2.f * Lanes<T>::fromBits(registers.bits[1] >> c) + 4.f * Lanes<T>::fromBits(registers.bits[2] >> c);
+		stepped *= .125f * gateOn;
+		pulsed = gateOn * Lanes<T>::fromBits(registers.xored >> c);    // Pulsed is the XOR result
+		// Calculate smoothed version of stepped function
+		smooth.setCutoffFreq(20.f * sampleTime);
+		smooth.process(stepped);
+	}
+};
+#endif // DIGITAL_CHAOTIC_SYSTEM_CORE_H
@@ -0,0 +1,71 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DIGITAL_CHAOTIC_SYSTEM_KERNEL_H
+#define DIGITAL_CHAOTIC_SYSTEM_KERNEL_H
+// Included after DigitalChaoticSystem.hpp, inside an anonymous namespace (see utils/simd_kernel.hpp)
+
+// All channels of DigitalChaoticSystem processed with vector type T (float_4 or float_8)
+template <typename T>
+struct DigitalChaoticSystemKernel : SimdKernel<DigitalChaoticSystem> {
+	static constexpr unsigned char size = Lanes<T>::size;
+	DigitalChaoticSystemCore<T> cores[PORT_MAX_CHANNELS / size];    // VCOs and register outputs, (size) channels per SIMD group
+	DigitalChaoticSystemRegisters registers;                        // Shift registers of all channels
+
+	void applySettings(DigitalChaoticSystem& module) override {}
+
+	void process(DigitalChaoticSystem& module, const Module::ProcessArgs& args) override {
+		const float* rate = module.rateNow;
+		const float* attv = module.attvNow;
+		uint16_t data = 0, clocked = 0;             // Register inputs of all channels, bit per channel
+		for (unsigned char c = 0; c < module.channels; c += size) {
+			unsigned char g = c / size;
+			DigitalChaoticSystemCore<T>& core = cores[g];
+			T frequencies[2];
+			for (unsigned char i = 0; i < 2; i++) {
+				frequencies[i] = rate[i];
+				if (module.rates[i].modulated) {
+					// Convert voltages to pitches: RATE + (k * X) + (k * X) + V/OCT
+					T pitch = rate[i];
+					pitch += module.inputs[DigitalChaoticSystem::CV + i].getPolyVoltageSimd<T>(c) * attv[i];
+					pitch += module.inputs[DigitalChaoticSystem::CV + 2 + i].getPolyVoltageSimd<T>(c) * attv[2 + i];
+					pitch += module.inputs[i ? DigitalChaoticSystem::VOCT2_INPUT : DigitalChaoticSystem::VOCT1_INPUT].getPolyVoltageSimd<T>(c);
+					// To Hertz
+					frequencies[i] = core.frequency(pitch);
+				}
+			}
+			core.processOscillators(args.sampleTime, frequencies, module.bandLimited);
+			for (unsigned char i = 0; i < 2; i++) {
+				module.outputs[DigitalChaoticSystem::VCOS + (i << 1)].setVoltageSimd(core.triangles[i], c);
+				module.outputs[DigitalChaoticSystem::VCOS + (i << 1) + 1].setVoltageSimd(core.squares[i], c);
+			}
+			// Clock and data inputs are normalized to VCOs' squares
+			T dataInput = module.inputs[DigitalChaoticSystem::DATA_INPUT].getNormalPolyVoltageSimd<T>(core.naiveSquares[1], c);
+			T clockInput = module.inputs[DigitalChaoticSystem::CLOCK_INPUT].getNormalPolyVoltageSimd<T>(core.naiveSquares[0], c);
+			int clockedLanes;
+			data |= core.registerInputs(dataInput, clockInput, clockedLanes) << c;
+			clocked |= clockedLanes << c;
+		}
+		// Clock the registers of all channels at once
+		registers.clock(data, clocked);
+		for (unsigned char c = 0; c < module.channels; c += size) {
+			DigitalChaoticSystemCore<T>& core = cores[c / size];
+			core.processRegister(args.sampleTime, registers, c);
+			module.outputs[DigitalChaoticSystem::PULSED_OUTPUT].setVoltageSimd(core.pulsed, c);
+			module.outputs[DigitalChaoticSystem::STEPPED_OUTPUT].setVoltageSimd(core.stepped, c);
+			module.outputs[DigitalChaoticSystem::SMOOTHED_OUTPUT].setVoltageSimd(core.smooth.lowpass(), c);
+		}
+	}
+};
+#endif // DIGITAL_CHAOTIC_SYSTEM_KERNEL_H
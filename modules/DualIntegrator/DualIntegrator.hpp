@@ -0,0 +1,127 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DUAL_INTEGRATOR_H
+#define DUAL_INTEGRATOR_H
+#include "../plugin.hpp"
+#include "DualIntegratorCore.hpp"
+
+struct DualIntegrator : Module {
+	enum ParamId {
+		ENUMS(SH_PARAM, 2),
+		ENUMS(CV1_ATTV_PARAM, 2),
+		ENUMS(RATE_PARAM, 2),
+		PARAMS_LEN
+	};
+	enum InputId {
+		ENUMS(IN_INPUT, 2),
+		ENUMS(GATE_INPUT, 2),
+		ENUMS(INF_INPUT, 2),
+		ENUMS(CV1_INPUT, 2),
+		ENUMS(CV2_INPUT, 2),
+		INPUTS_LEN
+	};
+	enum OutputId {
+		ENUMS(SLEW_OUTPUT, 2),
+		ENUMS(END_OUTPUT, 2),
+		CMP_OUTPUT,
+		OUTPUTS_LEN
+	};
+	enum LightId {
+		ENUMS(OUT_LED_LIGHT, 4),
+		ENUMS(SH_LED_LIGHT, 2),
+		LIGHTS_LEN
+	};
+
+	DualIntegrator() {
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		std::string cvStr = "CV";
+		for (unsigned char i = 0; i < 2; i++) {
+			configSwitch(SH_PARAM + i, 0.f, 1.f, 0.f, "Mode", {"Track & Hold", "Sample & Hold"});
+			configParam(CV1_ATTV_PARAM + i, -1.f, 1.f, 0.f, "CV Attenuverter");
+			configParam(RATE_PARAM + i, -5.f, 13.5f, 4.25f, "Rate", "Hz", 2.f);
+			configInput(IN_INPUT + i, "Signal");
+			configInput(GATE_INPUT + i, "Gate");
+			configInput(INF_INPUT + i, "Sample/Track and Hold");
+			configInput(CV1_INPUT + i, cvStr);
+			configInput(CV2_INPUT + i, cvStr);
+			configOutput(SLEW_OUTPUT + i, "Lag");
+			configOutput(END_OUTPUT + i, "End");
+		}
+		configOutput(CMP_OUTPUT, "Comparator (L>R)");
+		simdKernel.reset(createSimdKernel<DualIntegrator>());
+	}
+
+	std::unique_ptr<SimdKernel<DualIntegrator>> simdKernel;    // Slewing cells for the widest instruction set
+	ControlRate controlRate;                        // Schedules knob-only computations
+	CpuProfiler cpuProfiler;                        // Cost of process() (instrumented builds only)
+	ControlRateValue<> rates[2], attvs[2];          // RATE (in Hertz if not modulated) and CV1 attenuverter
+	DecimatedLights<LIGHTS_LEN> leds;               // OUT and S&H LEDs
+	bool cycle[2] = {};                             // Internal END to IN feedback of each cell (when IN is not connected)
+	unsigned char channels[2] = {1, 1};             // Number of polyphonic channels processed by each cell
+	float rateNow[2] = {}, attvNow[2] = {};         // Current values of rates and attvs, read by the kernel
+	bool holding[2] = {};                           // S&H/T&H Schmitt trigger of the first channel (set by the kernel)
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_t* cycleJ = json_array();
+		for (unsigned char i = 0; i < 2; i++) json_array_append_new(cycleJ, json_boolean(cycle[i]));
+		json_object_set_new(rootJ, "cycle", cycleJ);
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* cycleJ = json_object_get(rootJ, "cycle");
+		for (unsigned char i = 0; i < 2; i++) {
+			json_t* valueJ = json_array_get(cycleJ, i);
+			if (valueJ) cycle[i] = json_boolean_value(valueJ);
+		}
+	}
+
+	void process(const ProcessArgs& args) override {
+		CpuProfiler::Scope profile(cpuProfiler);
+		if (controlRate.process()) {
+			for (unsigned char i = 0; i < 2; i++) {
+				// Without CVs the slew rate only depends on the knob, convert it to Hertz here
+				bool modulated = inputs[CV1_INPUT + i].isConnected() || inputs[CV2_INPUT + i].isConnected();
+				float rate = params[RATE_PARAM + i].getValue();
+				rates[i].setTarget(controlRate, modulated ? rate : 20.f * std::pow(2.f, rate), modulated);
+				attvs[i].setTarget(controlRate, params[CV1_ATTV_PARAM + i].getValue());
+			}
+		}
+		for (unsigned char i = 0; i < 2; i++) {
+			// Each cell runs as many channels as its most polyphonic input (IN, GATE, S&H, CV1, CV2)
+			channels[i] = 1;
+			for (unsigned char j = i; j < INPUTS_LEN; j += 2) channels[i] = std::max(channels[i], (unsigned char) inputs[j].getChannels());
+			rateNow[i] = rates[i].process();
+			attvNow[i] = attvs[i].process();
+		}
+		simdKernel->process(*this, args);
+		for (unsigned char i = 0; i < 2; i++) {
+			outputs[SLEW_OUTPUT + i].setChannels(channels[i]);
+			outputs[END_OUTPUT + i].setChannels(channels[i]);
+			// Update LEDs (first channel only)
+			unsigned char twoI = (i << 1);
+			float led = outputs[SLEW_OUTPUT + i].getVoltage();
+			bool shToggle = params[SH_PARAM + i].getValue();
+			leds.accumulate(OUT_LED_LIGHT + twoI, std::max(0.f, .2f * led));
+			leds.accumulate(OUT_LED_LIGHT + 1 + twoI, std::max(0.f, -.2f * led));
+			leds.accumulate(SH_LED_LIGHT + i, shToggle ^ holding[i]);
+		}
+		if (leds.process()) leds.publish(lights, OUT_LED_LIGHT);
+		outputs[CMP_OUTPUT].setChannels(std::max(channels[0], channels[1]));
+	}
+};
+
+#endif // DUAL_INTEGRATOR_H
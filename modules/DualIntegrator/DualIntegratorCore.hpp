@@ -0,0 +1,66 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DUAL_INTEGRATOR_CORE_H
+#define DUAL_INTEGRATOR_CORE_H
+#include <rack.hpp>
+#include "../utils/fast_math.hpp"
+#include "../utils/lanes.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// One slewing cell of DualIntegrator, independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct DualIntegratorCore {
+	typedef typename Lanes<T>::Mask Mask;
+	rack::dsp::TSchmittTrigger<T> sh;           // S&H/T&H Schmitt Trigger
+	rack::dsp::TSlewLimiter<T> slew;            // The core of the slew routine
+	float endLow = -5.f, endHigh = 5.f;         // Threshold values for END Schmitt Trigger
+	rack::dsp::TSchmittTrigger<T> end;          // END Schmitt Trigger
+	T output = 0.f;                             // Slewed value (OUT output)
+	T endOutput = 0.f;                          // END output
+
+	// Converts the sum of rate CVs to Hertz
+	// Value 20 is chosen to match the frequency parameters: 2 * VoltagePeakToPeak
+	static T rate(T cv) { return 20.f * fastExp2(cv); }
+
+	// Slews the input with the given rate (in Hertz), S&H mode samples only on trigger, T&H tracks without gate.
+	// When cycling, END is fed back to the input inside the cell (the input is ignored): the slew turns around
+	// at the END thresholds within the sample instead of stopping there, so the period does not snap to whole samples.
+	void process(float sampleTime, T in, T gate, T shIn, T rate, bool sampleAndHold, bool cycle = false) {
+		// Gather S&H/T&H informations
+		Mask shTrigger = sh.process(shIn, triggerThresholdLevel, triggerThresholdLevel);
+		// Determine whether the cell slews, multiply the rate by 0 if holding a value
+		Mask active = sampleAndHold ? shTrigger : Lanes<T>::invert(sh.isHigh());
+		rate = ifelse(active, rate, 0.f);
+		// If gate inputs are active, assign 0 volts on input instead of the values
+		T input = ifelse(gate < triggerThresholdLevel, clamp(cycle ? endOutput : in, vMin, vMax), T(0.f));
+		// Travel left in this sample after reaching END threshold (only when cycling)
+		T overshoot = 0.f;
+		if (cycle) overshoot = rate * sampleTime - ifelse(input > 0.f, input - slew.out, slew.out - input);
+		// Update slew rate and perform slew
+		slew.setRiseFall(rate, rate);
+		output = slew.process(sampleTime, input);
+		// Update END Schmitt Trigger
+		end.process(output, endLow, endHigh);
+		endOutput = ifelse(end.isHigh(), -gateOn, gateOn);
+		if (!cycle) return;
+		// END has flipped at the threshold, continue towards the other one (at most to the other threshold)
+		Mask turn = (overshoot > 0.f) & ((input >= endHigh) | (input <= endLow));
+		T reflected = input - ifelse(input > 0.f, T(1.f), T(-1.f)) * clamp(overshoot, 0.f, endHigh - endLow);
+		output = ifelse(turn, reflected, output);
+		slew.out = output;
+	}
+};
+#endif // DUAL_INTEGRATOR_CORE_H
@@ -0,0 +1,70 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DUAL_INTEGRATOR_KERNEL_H
+#define DUAL_INTEGRATOR_KERNEL_H
+// Included after DualIntegrator.hpp, inside an anonymous namespace (see utils/simd_kernel.hpp)
+
+// All channels of DualIntegrator processed with vector type T (float_4 or float_8)
+template <typename T>
+struct DualIntegratorKernel : SimdKernel<DualIntegrator> {
+	static constexpr unsigned char size = Lanes<T>::size;
+	DualIntegratorCore<T> cells[2][PORT_MAX_CHANNELS / size];   // Slewing cells, (size) channels per SIMD group
+
+	void applySettings(DualIntegrator& module) override {}
+
+	void process(DualIntegrator& module, const Module::ProcessArgs& args) override {
+		for (unsigned char i = 0; i < 2; i++) {
+			bool shToggle = module.params[DualIntegrator::SH_PARAM + i].getValue();
+			bool cycle = module.cycle[i] && !module.inputs[DualIntegrator::IN_INPUT + i].isConnected();
+			float attv = module.attvNow[i];
+			float rate = module.rateNow[i];
+			for (unsigned char c = 0; c < module.channels[i]; c += size) {
+				unsigned char g = c / size;
+				T cv = rate;
+				if (module.rates[i].modulated) {
+					// Calculate incoming CVs: y = (x * A) + B + C
+					cv = module.inputs[DualIntegrator::CV1_INPUT + i].getPolyVoltageSimd<T>(c) * attv;
+					cv += module.inputs[DualIntegrator::CV2_INPUT + i].getPolyVoltageSimd<T>(c) + rate;
+					cv = DualIntegratorCore<T>::rate(cv);
+				}
+				DualIntegratorCore<T>& cell = cells[i][g];
+				cell.process(
+					args.sampleTime,
+					module.inputs[DualIntegrator::IN_INPUT + i].getPolyVoltageSimd<T>(c),
+					module.inputs[DualIntegrator::GATE_INPUT + i].getPolyVoltageSimd<T>(c),
+					module.inputs[DualIntegrator::INF_INPUT + i].getPolyVoltageSimd<T>(c),
+					cv,
+					shToggle,
+					cycle
+				);
+				// Update OUT and END
+				module.outputs[DualIntegrator::SLEW_OUTPUT + i].setVoltageSimd(cell.output, c);
+				module.outputs[DualIntegrator::END_OUTPUT + i].setVoltageSimd(cell.endOutput, c);
+			}
+			// Unused groups do not take part in the comparison
+			for (unsigned char g = (module.channels[i] + size - 1) / size; g < PORT_MAX_CHANNELS / size; g++) cells[i][g].output = T::zero();
+			module.holding[i] = Lanes<T>::bits(cells[i][0].sh.isHigh()) & 0x01;
+		}
+		// Output the comparison between two slewing cells, monophonic cell is compared against every channel
+		unsigned char cmpChannels = (module.channels[0] > module.channels[1]) ? module.channels[0] : module.channels[1];
+		for (unsigned char c = 0; c < cmpChannels; c += size) {
+			unsigned char g = c / size;
+			T left = (module.channels[0] == 1) ? T(Lanes<T>::lane(cells[0][0].output, 0)) : cells[0][g].output;
+			T right = (module.channels[1] == 1) ? T(Lanes<T>::lane(cells[1][0].output, 0)) : cells[1][g].output;
+			module.outputs[DualIntegrator::CMP_OUTPUT].setVoltageSimd(ifelse(left > right, T(gateOn), T(-gateOn)), c);
+		}
+	}
+};
+#endif // DUAL_INTEGRATOR_KERNEL_H
@@ -0,0 +1,158 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef NONLINEAR_INTEGRATOR_H
+#define NONLINEAR_INTEGRATOR_H
+#include "../plugin.hpp"
+#include "NonlinearIntegratorCore.hpp"
+
+struct NonlinearIntegrator : Module {
+	enum ParamId {
+		INPOT_PARAM,
+		F_PARAM,
+		Q_PARAM,
+		FATTV_PARAM,
+		QATTV_PARAM,
+		PARAMS_LEN
+	};
+	enum InputId {
+		TRIG_INPUT,
+		VOCT_INPUT,
+		FCV_INPUT,
+		QCV_INPUT,
+		IN_INPUT,
+		INPUTS_LEN
+	};
+	enum OutputId {
+		LP_OUTPUT,
+		BP_OUTPUT,
+		HP_OUTPUT,
+		NP_OUTPUT,
+		OUTPUTS_LEN
+	};
+	enum LightId {
+		LIGHTS_LEN
+	};
+
+	NonlinearIntegrator() {
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		std::string inputLabels[4] = {"Trigger", "Frequency V/Oct", "Frequency CV", "Resonance CV"};
+		std::string modes[4] = {"Low", "Band", "High", "Notch"};
+		for (unsigned char i = 0; i < 4; i++) {
+			configOutput(i, modes[i]);
+			configInput(i, inputLabels[i]);
+		}
+		configInput(IN_INPUT, "Signal");
+		configParam(INPOT_PARAM, 0.f, 1.f, 0.f, "Signal attenuator");
+		configParam(F_PARAM, -4.f, 13.f, -4.f, "Frequency", "Hz", 2.f);
+		configParam(FATTV_PARAM, -1.f, 1.f, 0.f, "Frequency CV attenuverter");
+		configParam(Q_PARAM, 0.f, 12.f, 0.f, "Resonance", "", 0.f, 1.f/12.f);
+		configParam(QATTV_PARAM, -2.f, 2.f, 0.f, "Resonance CV attenuverter", "", 0.f, 0.5f);
+		simdKernel.reset(createSimdKernel<NonlinearIntegrator>());
+		buildCoefficients();
+		applySettings();
+	}
+
+	unsigned char channels = 1;                             // Number of polyphonic channels
+	std::unique_ptr<SimdKernel<NonlinearIntegrator>> simdKernel;    // Filters for the widest instruction set
+	NonlinearIntegratorCoefficients coefficientSets[2][4];  // Filter coefficients for every engine and oversampling
+	const NonlinearIntegratorCoefficients* coefficients = &coefficientSets[0][0];  // Coefficients in use, shared by all channels
+	Prng prng;                                              // Noise source for self oscillation
+	float sampleTime = 1.f / 44100.f;                       // Engine sample time
+	unsigned char oversampling = 0;                         // Requested oversampling: 0 (off), 1 (2x), 2 (4x), 3 (8x)
+	unsigned char activeOversampling = 0;                   // Oversampling the filter currently runs with
+	unsigned char engine = 0;                               // Requested filter engine: 0 (Chamberlin), 1 (zero-delay feedback)
+	unsigned char activeEngine = 0;                         // Filter engine currently in use
+	OversamplingKernel kernel;                              // Resampling filter shared by all resamplers
+	ControlRate controlRate;                                // Schedules knob-only computations
+	CpuProfiler cpuProfiler;                                // Cost of process() (instrumented builds only)
+	ControlRateValue<> inLevel, fAttv, qAttv;               // Input level and CV attenuverters
+	ControlRateValue<> frequency, resonance;                // F and Q knobs (filter coefficients if not modulated)
+	bool cycle = false;                                     // Internal BAND to IN feedback (when IN is not connected)
+	float inLevelNow = 0.f, fAttvNow = 0.f, qAttvNow = 0.f; // Current values of the ControlRateValues, read by the kernel
+	float frequencyNow = 0.f, resonanceNow = 0.f;
+	float noise[PORT_MAX_CHANNELS] = {};                    // Noise added to the input of each channel in this sample
+
+	// Builds coefficients (and lookup tables) of all engines and oversampling factors for the engine sample rate,
+	// so switching them on the audio thread only selects another set
+	void buildCoefficients() {
+		for (unsigned char e = 0; e < 2; e++)
+			for (unsigned char o = 0; o < 4; o++) coefficientSets[e][o].build(e, sampleTime / (1 << o));
+	}
+
+	// Rebuilds everything that depends on the filter's engine and (internal) sample rate
+	void applySettings() {
+		simdKernel->applySettings(*this);
+		activeEngine = engine;
+		activeOversampling = oversampling;
+		kernel.setFactor(1 << activeOversampling);
+		coefficients = &coefficientSets[activeEngine][activeOversampling];
+		// Coefficients derived from knobs are no longer valid
+		controlRate.reset();
+	}
+
+	void onSampleRateChange(const SampleRateChangeEvent& e) override {
+		sampleTime = e.sampleTime;
+		buildCoefficients();
+		applySettings();
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "oversampling", json_integer(oversampling));
+		json_object_set_new(rootJ, "engine", json_integer(engine));
+		json_object_set_new(rootJ, "cycle", json_boolean(cycle));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* oversamplingJ = json_object_get(rootJ, "oversampling");
+		if (oversamplingJ) oversampling = clamp((int) json_integer_value(oversamplingJ), 0, 3);
+		json_t* engineJ = json_object_get(rootJ, "engine");
+		if (engineJ) engine = clamp((int) json_integer_value(engineJ), 0, 1);
+		json_t* cycleJ = json_object_get(rootJ, "cycle");
+		if (cycleJ) cycle = json_boolean_value(cycleJ);
+	}
+
+	void process(const ProcessArgs& args) override {
+		CpuProfiler::Scope profile(cpuProfiler);
+		// Settings are changed from the UI thread, apply them here
+		if (oversampling != activeOversampling || engine != activeEngine) applySettings();
+		channels = 1;
+		for (unsigned char i = 0; i < INPUTS_LEN; i++) channels = std::max(channels, (unsigned char) inputs[i].getChannels());
+		if (controlRate.process()) {
+			// Without CVs the filter coefficients only depend on the knobs, compute them here
+			bool fModulated = inputs[FCV_INPUT].isConnected() || inputs[VOCT_INPUT].isConnected();
+			bool qModulated = inputs[QCV_INPUT].isConnected();
+			float fPot = params[F_PARAM].getValue(), qPot = params[Q_PARAM].getValue();
+			frequency.setTarget(controlRate, fModulated ? fPot : coefficients->frequency(fPot), fModulated);
+			resonance.setTarget(controlRate, qModulated ? qPot : coefficients->resonance(qPot), qModulated);
+			inLevel.setTarget(controlRate, params[INPOT_PARAM].getValue());
+			fAttv.setTarget(controlRate, params[FATTV_PARAM].getValue());
+			qAttv.setTarget(controlRate, params[QATTV_PARAM].getValue());
+		}
+		inLevelNow = inLevel.process();
+		fAttvNow = fAttv.process();
+		frequencyNow = frequency.process();
+		qAttvNow = qAttv.process();
+		resonanceNow = resonance.process();
+		// Here we use random to enable self oscillation when BANDPASS is connected back to INPUT
+		// (for whole SIMD groups, up to 8 channels)
+		for (unsigned char c = 0; c < ((channels + 7) & ~7); c++) noise[c] = 1e-6f * (2.f * prng.uniform() - 1.f);
+		simdKernel->process(*this, args);
+		for (unsigned char i = 0; i < OUTPUTS_LEN; i++) outputs[i].setChannels(channels);
+	}
+};
+
+#endif // NONLINEAR_INTEGRATOR_H
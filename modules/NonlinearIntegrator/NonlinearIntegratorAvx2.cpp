@@ -0,0 +1,27 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifdef KERNELS_AVX2
+#include "../utils/float_8.hpp"
+#include "NonlinearIntegrator.hpp"
+
+namespace {
+#include "NonlinearIntegratorKernel.hpp"
+}
+
+template <>
+SimdKernel<NonlinearIntegrator>* createAvx2Kernel<NonlinearIntegrator>() {
+	return new NonlinearIntegratorKernel<simd::float_8>;
+}
+#endif
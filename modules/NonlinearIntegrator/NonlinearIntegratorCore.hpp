@@ -0,0 +1,146 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef NONLINEAR_INTEGRATOR_CORE_H
+#define NONLINEAR_INTEGRATOR_CORE_H
+#include <rack.hpp>
+#include "../utils/fast_math.hpp"
+#include "../utils/lanes.hpp"
+#include "../utils/lookup_table.hpp"
+#include "../utils/oversampler.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// Filter coefficients of NonlinearIntegrator, shared by all channels.
+// They depend on the filter engine and the internal (oversampled) sample rate.
+struct NonlinearIntegratorCoefficients {
+	float fMin = -4.f, fMax = 13.f;                         // Frequency voltage limits
+	float qMin = 0.f, qMax = 12.f;                          // Resonance voltage limits
+	float qMultiplier = -.05f * 108900.f / 15330.f;         // Resonance scaling factor
+	unsigned char engine = 0;                               // Filter engine: 0 (Chamberlin), 1 (zero-delay feedback)
+	float filterSampleTime = 1.f / 44100.f;                 // Sample time the filter runs with (oversampled)
+	LookupTable fTable;                                     // Zero-delay feedback frequency coefficients for limited voltages
+
+	void build(unsigned char engine, float filterSampleTime) {
+		this->engine = engine;
+		this->filterSampleTime = filterSampleTime;
+		if (engine) {
+			// Prewarped integrator gain, the frequency is limited just below Nyquist
+			fTable.build(fMin, fMax, 64, [filterSampleTime](float fcv) { return std::tan(M_PI * std::min(0.49f, filterSampleTime * std::pow(2.f, fcv))); });
+		}
+	}
+
+	// Filter frequency coefficient for frequency voltages
+	template <typename T>
+	T frequency(T fcv) const {
+		fcv = clamp(fcv, fMin, fMax);
+		if (engine) return fTable.process(fcv);
+		return 2.f * fastSin(float(M_PI) * filterSampleTime * fastExp2(fcv));
+	}
+
+	// Filter damping coefficient for resonance voltages
+	template <typename T>
+	T resonance(T qcv) const {
+		return fastExp10(qMultiplier * clamp(qcv, qMin, qMax));
+	}
+};
+
+// State variable filter of NonlinearIntegrator (one set of channels), independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct NonlinearIntegratorCore {
+	typedef typename Lanes<T>::Mask Mask;
+	float inMin = -12.f, inMax = 12.f;                      // Signal limits
+	rack::dsp::TSchmittTrigger<T> st;                       // Used for detecting rising edge on PING input
+	rack::dsp::TPulseGenerator<T> pg;                       // Used for generating short pulse when filter is pinged
+	T states[4] = {};                                       // Filter states (LOWPASS, BANDPASS, HIGHPASS, NOTCH)
+	T integrators[2] = {};                                  // Zero-delay feedback engine integrators (BANDPASS, LOWPASS)
+	PolyphaseUpsampler<T> upsampler;                        // Input signal upsampler
+	PolyphaseDecimator<T> decimators[4];                    // Output decimators
+	T out[4] = {};                                          // Outputs (LOWPASS, BANDPASS, HIGHPASS, NOTCH)
+
+	// Continues from the current filter state after the engine is switched to zero-delay feedback
+	void carryStates() {
+		integrators[0] = states[1];
+		integrators[1] = states[0];
+	}
+
+	void resetResamplers() {
+		upsampler.reset();
+		for (unsigned char i = 0; i < 4; i++) decimators[i].reset();
+	}
+
+	// Single step of the Chamberlin filter (at the internal sample rate)
+	void updateStates(T in, T f, T q) {
+		states[3] = (q * states[1] - in);
+		states[2] = (-(states[3] + states[0]));
+		states[1] = (states[1] + f * states[2]);
+		states[0] = (states[0] + (f * states[1]));
+		// Clamp the values
+		for (unsigned char i = 0; i < 4; i++) states[i] = clamp(states[i], vMin, vMax);
+	}
+
+	// Single step of the topology-preserving transform (zero-delay feedback) filter, stable up to Nyquist.
+	// Here f is the prewarped integrator gain and q is the damping, the same as in Chamberlin engine.
+	// Integrator outputs are clamped the same way as the Chamberlin states to keep the nonlinear character.
+	void updateStatesZdf(T in, T f, T q) {
+		T a1 = 1.f / (1.f + f * (f + q));
+		T a2 = f * a1;
+		T a3 = f * a2;
+		T v3 = in - integrators[1];
+		states[1] = clamp(a1 * integrators[0] + a2 * v3, vMin, vMax);
+		states[0] = clamp(integrators[1] + a2 * integrators[0] + a3 * v3, vMin, vMax);
+		integrators[0] = 2.f * states[1] - integrators[0];
+		integrators[1] = 2.f * states[0] - integrators[1];
+		// HIGHPASS and NOTCH (with the same polarity as in Chamberlin engine)
+		states[2] = clamp(in - q * states[1] - states[0], vMin, vMax);
+		states[3] = clamp(q * states[1] - in, vMin, vMax);
+	}
+
+	// Single filter step with the internal BANDPASS to input feedback. Adding BANDPASS (scaled by feedback)
+	// to the input equals lowering the damping by feedback, so the zero-delay feedback engine solves it
+	// together with the filter, without delay. Chamberlin engine adds BANDPASS of the previous step,
+	// one (oversampled) sample late, the same as its own damping path.
+	void step(const NonlinearIntegratorCoefficients& coefficients, T in, T f, T q, float feedback) {
+		if (coefficients.engine) updateStatesZdf(in, f, q - feedback);
+		else updateStates(feedback ? clamp(in + feedback * states[1], inMin, inMax) : in, f, q);
+	}
+
+	// Filters the input (scaled, with noise) with coefficients f and q; PING trigger injects a short pulse.
+	// Non-zero feedback is applied in every filter step (see step()), so the filter cycles without
+	// the delays of a cable and of the resamplers.
+	void process(float sampleTime, const NonlinearIntegratorCoefficients& coefficients, const OversamplingKernel& kernel, T in, T ping, T f, T q, float feedback = 0.f) {
+		// If the filter is pinged, generate a short pulse on input
+		Mask pinged = st.process(ping, triggerThresholdLevel, triggerThresholdLevel);
+		pg.trigger(ifelse(pinged, T(1e-3f), T(0.f)));
+		in += 6.f * pg.process(sampleTime);
+		// Limit the values to acceptable range
+		in = clamp(in, inMin, inMax);
+		// Without oversampling, update filter states and output
+		if (kernel.factor == 1) {
+			step(coefficients, in, f, q, feedback);
+			for (unsigned char i = 0; i < 4; i++) out[i] = states[i];
+			return;
+		}
+		// Otherwise, run the filter (factor) times on the upsampled input (parameters are kept constant)
+		T upsampled[OVERSAMPLING_MAX_FACTOR], taps[4][OVERSAMPLING_MAX_FACTOR];
+		upsampler.process(kernel, in, upsampled);
+		for (unsigned char k = 0; k < kernel.factor; k++) {
+			step(coefficients, upsampled[k], f, q, feedback);
+			for (unsigned char i = 0; i < 4; i++) taps[i][k] = states[i];
+		}
+		// Decimate
+		for (unsigned char i = 0; i < 4; i++) out[i] = clamp(decimators[i].process(kernel, taps[i]), vMin, vMax);
+	}
+};
+#endif // NONLINEAR_INTEGRATOR_CORE_H
@@ -0,0 +1,58 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef NONLINEAR_INTEGRATOR_KERNEL_H
+#define NONLINEAR_INTEGRATOR_KERNEL_H
+// Included after NonlinearIntegrator.hpp, inside an anonymous namespace (see utils/simd_kernel.hpp)
+
+// All channels of NonlinearIntegrator processed with vector type T (float_4 or float_8)
+template <typename T>
+struct NonlinearIntegratorKernel : SimdKernel<NonlinearIntegrator> {
+	static constexpr unsigned char size = Lanes<T>::size;
+	NonlinearIntegratorCore<T> cores[PORT_MAX_CHANNELS / size];     // Filters, (size) channels per SIMD group
+
+	void applySettings(NonlinearIntegrator& module) override {
+		for (unsigned char g = 0; g < PORT_MAX_CHANNELS / size; g++) {
+			// Continue from the current filter state
+			if (module.engine != module.activeEngine) cores[g].carryStates();
+			cores[g].resetResamplers();
+		}
+	}
+
+	void process(NonlinearIntegrator& module, const Module::ProcessArgs& args) override {
+		float inPot = module.inLevelNow;
+		float fCvAttv = module.fAttvNow, fPot = module.frequencyNow;
+		float qCvAttv = module.qAttvNow, qPot = module.resonanceNow;
+		// BAND is fed back through the signal attenuator, like a cable patched to IN
+		float feedback = (module.cycle && !module.inputs[NonlinearIntegrator::IN_INPUT].isConnected()) ? inPot : 0.f;
+		for (unsigned char c = 0; c < module.channels; c += size) {
+			unsigned char g = c / size;
+			// Process all inputs: y = (x * a) + b
+			T in = module.inputs[NonlinearIntegrator::IN_INPUT].getPolyVoltageSimd<T>(c) * inPot + T::load(&module.noise[c]);
+			// Update filter parameters (per channel), only modulated ones are converted here
+			T f = fPot, q = qPot;
+			if (module.frequency.modulated) {
+				T fcv = module.inputs[NonlinearIntegrator::FCV_INPUT].getPolyVoltageSimd<T>(c) * fCvAttv + fPot + module.inputs[NonlinearIntegrator::VOCT_INPUT].getPolyVoltageSimd<T>(c);
+				f = module.coefficients->frequency(fcv);
+			}
+			if (module.resonance.modulated) {
+				T qcv = module.inputs[NonlinearIntegrator::QCV_INPUT].getPolyVoltageSimd<T>(c) * qCvAttv + qPot;
+				q = module.coefficients->resonance(qcv);
+			}
+			cores[g].process(args.sampleTime, *module.coefficients, module.kernel, in, module.inputs[NonlinearIntegrator::TRIG_INPUT].getPolyVoltageSimd<T>(c), f, q, feedback);
+			for (unsigned char i = 0; i < 4; i++) module.outputs[i].setVoltageSimd(cores[g].out[i], c);
+		}
+	}
+};
+#endif // NONLINEAR_INTEGRATOR_KERNEL_H
@@ -13,8 +13,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 #include "../plugin.hpp"
+#include "VoltageSequencerCore.hpp"
 
-using dsp::TSchmittTrigger;
 using simd::float_4;
 
 struct VoltageSequencer : Module {
@@ -24,6 +24,9 @@ struct VoltageSequencer : Module {
 		ENUMS(MAN_PARAM, 8),
 		CLOCK_EN_PARAM,
 		VCLOCK_EN_PARAM,
+		ENUMS(A_EXT_PARAM, 56),
+		ENUMS(B_EXT_PARAM, 56),
+		ENUMS(MAN_EXT_PARAM, 56),
 		PARAMS_LEN
 	};
 	enum InputId {
@@ -54,23 +57,35 @@ struct VoltageSequencer : Module {
 		LIGHTS_LEN
 	};
 
-	float_4 signals;                            // For priority trigger inputs: DIRECTION, VERTICAL_CLOCK, RESET
-	TSchmittTrigger<float_4> sigTriggers;       // Processing priority triggers
-	unsigned char direction = 0;                // Sequencer direction: 0 (to the right), 1 (to the left)
-	unsigned char vStage = 1;                   // Sequencer vertical stage: 0 (Row A), 1 (Row B)
-	unsigned char changeInfo = 0x00;            // Signal Bitmask (alligned to right): Reset, Preset, Clock, Stage Selected
-	TSchmittTrigger<float> presetTrig, clock;   // Additional triggers
-	signed char stage = 0, newStage = 0;        // Sequencer stage and new stage
-	unsigned char preset = 0;                   // Sequencer preset stage
+	unsigned char channels = 1;                 // Number of polyphonic channels (independent playheads)
+	VoltageSequencerCore<float_4> cores[4];     // Playheads, 4 channels per SIMD group
+	unsigned char preset = 0;                   // Sequencer preset stage (shared by all channels)
 	float stageVoltageFactor = 1.f / 6.f;       // Whole tone step for STAGE output
+	ControlRate controlRate;                    // Schedules knob-only computations
+	CpuProfiler cpuProfiler;                    // Cost of process() (instrumented builds only)
+	float a[64] = {}, b[64] = {};               // Row A & B values (stepped, so evaluated at control rate without smoothing)
+	uint64_t buttons = 0;                       // Stage Select Buttons mask (bit per stage)
+	unsigned char stageCount = 0;               // Requested number of stages: 0 (8), 1 (16), 2 (32), 3 (64)
+	unsigned char stages = 8;                   // Number of stages the sequencer currently runs with
+	unsigned char page = 0;                     // Page of 8 stages shown on the panel
+	unsigned char gatePage = 0;                 // Page the Stage Gate Outputs were written for
+	bool selectPages = false;                   // Channel N of Stage Select Gate Inputs selects the stage on page N
+	bool refresh = true;                        // Outputs of all channels have to be written again (knob move, channel or setting change, un-bypass, reset)
+	DecimatedLights<LIGHTS_LEN> leds;           // Stage and vertical stage LEDs (lit for the time spent in the stage)
+
+	// Parameter IDs of the stage (first 8 stages keep their original IDs)
+	static int aParam(unsigned char stage) { return (stage < 8) ? A_PARAM + stage : A_EXT_PARAM + stage - 8; }
+	static int bParam(unsigned char stage) { return (stage < 8) ? B_PARAM + stage : B_EXT_PARAM + stage - 8; }
+	static int manParam(unsigned char stage) { return (stage < 8) ? MAN_PARAM + stage : MAN_EXT_PARAM + stage - 8; }
 
 	VoltageSequencer() {
 		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
-		for (unsigned char i = 0; i < 8; i++) {
+		for (unsigned char i = 0; i < 64; i++) {
 			std::string stageStr = "Stage " + std::to_string(i + 1);
-			configParam(i, 0.f, 5.f, 0.f, stageStr + "A", "V");
-			configParam(i + 8, 0.f, 5.f, 0.f, stageStr + "B", "V");
-			configParam(i + 16, 0.f, 1.f, 0.f, stageStr + " Manual Select");
+			configParam(aParam(i), 0.f, 5.f, 0.f, stageStr + "A", "V");
+			configParam(bParam(i), 0.f, 5.f, 0.f, stageStr + "B", "V");
+			configParam(manParam(i), 0.f, 1.f, 0.f, stageStr + " Manual Select");
+			if (i >= 8) continue;
 			configInput(i, stageStr + " Select Trigger");
 			configOutput(i, stageStr + " Gate");
 		}
@@ -91,86 +106,145 @@ struct VoltageSequencer : Module {
 		configOutput(MAX_OUTPUT, "max(A,B)");
 		configOutput(STAGE_OUTPUT, "Stage");
 		configOutput(AB_OUTPUT, "A or B (Vertical Clock)");
-		// Prepare state before processing
-		changeState(0);
-		changeVState();
+		// Prepare LEDs before processing
+		lights[LED_LIGHT].setBrightness(ledOn);
+		lights[LEDSEL].setBrightness(ledOn);
+	}
+
+	// Changes the number of stages, playheads and preset stage beyond the last stage return to stage 1
+	void applySettings() {
+		stages = 8 << stageCount;
+		for (unsigned char g = 0; g < 4; g++) cores[g].stage = ifelse(cores[g].stage >= stages, float_4(0.f), cores[g].stage);
+		if (preset >= stages) preset = 0;
+		page = std::min(page, (unsigned char) ((stages >> 3) - 1));
+		// Row values and buttons of the added stages are read on the next sample
+		controlRate.reset();
+		refresh = true;
 	}
 
-	void changeState(signed char newStage) {
-		// Turn the current LED off and GATE output off
-		lights[stage].setBrightness(ledOff);
-		outputs[stage].setVoltage(gateOff);
-		stage = newStage & 0x07;            // Update the stage (and limit the value to 0-7 range)
-		lights[stage].setBrightness(ledOn); // Turn on the new LED
+	// Rack zeroes the outputs of a bypassed module, the outputs of a reset or added one hold stale values,
+	// in all cases they have to be written again without waiting for the next clock edge
+	void onUnBypass(const UnBypassEvent& e) override {
+		Module::onUnBypass(e);
+		refresh = true;
 	}
 
-	void changeVState() {
-		lights[vStage + 8].setBrightness(ledOff);  // Turn off the current LED
-		vStage = (vStage + 1) & 0x01;              // Update VERTICAL STAGE (limit to 0-1)
-		lights[vStage + 8].setBrightness(ledOn);   // Turn new LED on
+	void onReset(const ResetEvent& e) override {
+		Module::onReset(e);
+		refresh = true;
+	}
+
+	void onAdd(const AddEvent& e) override {
+		Module::onAdd(e);
+		refresh = true;
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "stages", json_integer(stageCount));
+		json_object_set_new(rootJ, "page", json_integer(page));
+		json_object_set_new(rootJ, "selectPages", json_boolean(selectPages));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* stagesJ = json_object_get(rootJ, "stages");
+		if (stagesJ) stageCount = clamp((int) json_integer_value(stagesJ), 0, 3);
+		json_t* pageJ = json_object_get(rootJ, "page");
+		// Limited by the loaded stage count, applySettings() is not called if it equals the current one
+		if (pageJ) page = clamp((int) json_integer_value(pageJ), 0, (1 << stageCount) - 1);
+		json_t* selectPagesJ = json_object_get(rootJ, "selectPages");
+		if (selectPagesJ) selectPages = json_boolean_value(selectPagesJ);
+	}
+
+	// Returns Stage Select Gate Inputs and Buttons as a mask (bit per stage).
+	// By default the first channel of the gate input (i) selects stage i of the shown page.
+	// With selectPages, channel (p) selects stage 8p + i, so bits of all inputs
+	// (byte per input, bit per channel) are transposed to bits of stages (byte per page).
+	uint64_t selectMask() {
+		if (!selectPages) {
+			uint64_t gates = 0;
+			for (unsigned char i = 0; i < 8; i++) gates |= (uint64_t) (inputs[i].getVoltage() >= triggerThresholdLevel) << i;
+			return (gates << (page << 3)) | buttons;
+		}
+		unsigned char pageMask = (1 << (stages >> 3)) - 1;
+		uint64_t gates = 0;
+		for (unsigned char i = 0; i < 8; i++) {
+			unsigned char high = movemask(inputs[i].getVoltageSimd<float_4>(0) >= triggerThresholdLevel);
+			high |= movemask(inputs[i].getVoltageSimd<float_4>(4) >= triggerThresholdLevel) << 4;
+			gates |= (uint64_t) (high & pageMask & ((1 << inputs[i].getChannels()) - 1)) << (i << 3);
+		}
+		return transposeBits(gates) | buttons;
 	}
 
 	void process(const ProcessArgs& args) override {
-		// Process incoming priority triggers
-		signals = sigTriggers.process(
-			float_4(
-				inputs[DIRECTION_INPUT].getVoltage(),
-				params[VCLOCK_EN_PARAM].getValue() * inputs[VCLOCK_IN_INPUT].getVoltage(),
-				inputs[RESET_INPUT].getVoltage(),
-				0.f
-			),
-			triggerThresholdLevel,
-			triggerThresholdLevel
-		);
-		if (signals[0]) direction = (direction + 1) & 0x01; // Direction change
-		if (signals[1]) changeVState();                     // Vertical stage change
-
-		newStage = 0;                       // Default new stage (in case the change is needed)
-		changeInfo = bool(signals[2]) << 3; // Fill the info with reset trigger value
-		// If no triggers detected so far...
-		if (!changeInfo) {
-			// Check whether manual or voltage stage select is active
-			for (unsigned char i = 0; i < 8; i++) {
-				if (inputs[i].getVoltage() + (10.f * params[i + 16].getValue()) < triggerThresholdLevel) continue;
-				preset = i;
-				changeInfo |= 0x01;
-				break;
-			}
-			// Or check whether PRESET also has been requested
-			if (changeInfo || presetTrig.process(inputs[PRESET_INPUT].getVoltage(), triggerThresholdLevel, triggerThresholdLevel)) {
-				newStage = preset;
-				changeInfo |= 0x04;
-			}
-			// Otherwise, check if the CLOCK edge is detected and we are not HOLDing
-			else if (
-				inputs[HOLD_INPUT].getVoltage() < triggerThresholdLevel &&
-				clock.process(params[CLOCK_EN_PARAM].getValue() * inputs[CLOCK_IN_INPUT].getVoltage(), triggerThresholdLevel, triggerThresholdLevel)
-			) {
-				newStage = stage + ((direction) ? -1 : 1);
-				changeInfo |= 0x02;
+		CpuProfiler::Scope profile(cpuProfiler);
+		// Settings are changed from the UI thread, apply them here
+		if (stages != (8 << stageCount)) applySettings();
+		unsigned char newChannels = 1;
+		for (unsigned char i = RESET_INPUT; i < INPUTS_LEN; i++) newChannels = std::max(newChannels, (unsigned char) inputs[i].getChannels());
+		refresh |= (newChannels != channels) | (page != gatePage);
+		channels = newChannels;
+		gatePage = page;
+		// Get Row A & B values and Stage Select Buttons, outputs change only if any knob has moved
+		if (controlRate.process()) {
+			buttons = 0;
+			for (unsigned char i = 0; i < stages; i++) {
+				float aValue = params[aParam(i)].getValue(), bValue = params[bParam(i)].getValue();
+				refresh |= (aValue != a[i]) | (bValue != b[i]);
+				a[i] = aValue;
+				b[i] = bValue;
+				buttons |= (uint64_t) (params[manParam(i)].getValue() > 0.f) << i;
 			}
 		}
-		// Change sequencer state if any change was requested
-		if (changeInfo) changeState(newStage);
-		// Turn on the correct GATE output and ALL GATES
-		// (if manual or voltage stage select was triggered)
-		outputs[stage].setVoltage(gateOn);
-		outputs[ALLGATES_OUTPUT].setVoltage(gateOn * (changeInfo & 0x01));
-		// Get Row A & B values
-		float a = params[stage].getValue();
-		float b = params[stage + 8].getValue();
-		// Assign correct values to outputs
-		outputs[A_OUT_OUTPUT].setVoltage(a);
-		outputs[B_OUT_OUTPUT].setVoltage(b);
-		outputs[A_B_OUTPUT].setVoltage(a-b);
-		outputs[MIN_OUTPUT].setVoltage(std::min(a, b));
-		outputs[MAX_OUTPUT].setVoltage(std::max(a, b));
-		outputs[STAGE_OUTPUT].setVoltage(stage * stageVoltageFactor);
-		outputs[AB_OUTPUT].setVoltage((vStage) ? b : a);
+		// Check whether manual or voltage stage select is active (shared by all channels),
+		// the leftmost selected stage (lowest bit) has priority
+		uint64_t selectedStages = selectMask();
+		bool selected = selectedStages;
+		if (selected) preset = __builtin_ctzll(selectedStages);
+		float clockEnable = params[CLOCK_EN_PARAM].getValue(), vClockEnable = params[VCLOCK_EN_PARAM].getValue();
+		for (unsigned char c = 0; c < channels; c += 4) {
+			unsigned char g = (c >> 2);
+			VoltageSequencerCore<float_4>& core = cores[g];
+			bool changed = core.process(
+				inputs[RESET_INPUT].getPolyVoltageSimd<float_4>(c),
+				inputs[PRESET_INPUT].getPolyVoltageSimd<float_4>(c),
+				inputs[DIRECTION_INPUT].getPolyVoltageSimd<float_4>(c),
+				vClockEnable * inputs[VCLOCK_IN_INPUT].getPolyVoltageSimd<float_4>(c),
+				clockEnable * inputs[CLOCK_IN_INPUT].getPolyVoltageSimd<float_4>(c),
+				inputs[HOLD_INPUT].getPolyVoltageSimd<float_4>(c),
+				selected, preset, stages
+			);
+			// Outputs hold their values until the next edge or knob move
+			if (!(changed || refresh)) continue;
+			core.gather(a, b);
+			// Turn on the correct GATE output (only for stages on the shown page) and ALL GATES
+			float_4 pageStage = core.stage - float(page << 3);
+			for (unsigned char i = 0; i < 8; i++) outputs[GATEOUT_OUTPUT + i].setVoltageSimd(ifelse(pageStage == i, gateOn, gateOff), c);
+			outputs[ALLGATES_OUTPUT].setVoltageSimd(core.allGates, c);
+			float_4 aValues = core.aValues, bValues = core.bValues;
+			// Assign correct values to outputs
+			outputs[A_OUT_OUTPUT].setVoltageSimd(aValues, c);
+			outputs[B_OUT_OUTPUT].setVoltageSimd(bValues, c);
+			outputs[A_B_OUTPUT].setVoltageSimd(aValues - bValues, c);
+			outputs[MIN_OUTPUT].setVoltageSimd(fmin(aValues, bValues), c);
+			outputs[MAX_OUTPUT].setVoltageSimd(fmax(aValues, bValues), c);
+			outputs[STAGE_OUTPUT].setVoltageSimd(core.stage * stageVoltageFactor, c);
+			outputs[AB_OUTPUT].setVoltageSimd(ifelse(core.vStage, bValues, aValues), c);
+		}
+		refresh = false;
+		for (unsigned char i = 0; i < OUTPUTS_LEN; i++) outputs[i].setChannels(channels);
+		// Update LEDs (first channel only, the stage LED is lit only if the stage is on the shown page)
+		unsigned char stage = cores[0].stage[0];
+		if ((stage >> 3) == page) leds.accumulate(LED_LIGHT + (stage & 0x07), ledOn);
+		leds.accumulate(LEDSEL + (movemask(cores[0].vStage) & 0x01), ledOn);
+		if (leds.process()) leds.publish(lights, LED_LIGHT);
 	}
 };
 
 struct VoltageSequencerWidget : ModuleWidget {
+	std::vector<Widget*> pageWidgets[8];        // Knobs and buttons of each page of 8 stages
+
 	VoltageSequencerWidget(VoltageSequencer* module) {
 		setModule(module);
 		setPanel(createPanel(asset::plugin(pluginInstance, "modules/VoltageSequencer/VoltageSequencer.svg")));
@@ -184,9 +258,20 @@ struct VoltageSequencerWidget : ModuleWidget {
 			addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(x, yCoords(1))), module, i));
 			addChild(createLightCentered<MediumLight<RedLight>>(mm2px(Vec(x, 0.5f * (yCoords(1) + yCoords(2)))), module, i));
 			addInput(createInputCentered<PJ301MPort>(mm2px(Vec(x, yCoords(2))), module, i));
-			addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(x, yCoords(3))), module, i));
-			addParam(createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(x, yCoords(4))), module, i + 8));
-			addParam(createParamCentered<CKD6>(mm2px(Vec(x, yCoords(5))), module, i + 16));
+			// Knobs and buttons of all pages share their places, only the shown page is visible
+			for (unsigned char p = 0; p < 8; p++) {
+				unsigned char stage = (p << 3) + i;
+				ParamWidget* widgets[3] = {
+					createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(x, yCoords(3))), module, VoltageSequencer::aParam(stage)),
+					createParamCentered<RoundLargeBlackKnob>(mm2px(Vec(x, yCoords(4))), module, VoltageSequencer::bParam(stage)),
+					createParamCentered<CKD6>(mm2px(Vec(x, yCoords(5))), module, VoltageSequencer::manParam(stage))
+				};
+				for (ParamWidget* widget : widgets) {
+					widget->visible = !p;
+					addParam(widget);
+					pageWidgets[p].push_back(widget);
+				}
+			}
 		}
 		for (unsigned char i = 0; i < 2; i++) {
 			float x = xCoords(i + 8);
@@ -198,5 +283,25 @@ struct VoltageSequencerWidget : ModuleWidget {
 		}
 		addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(xCoords(8), yCoords(1))), module, VoltageSequencer::ALLGATES_OUTPUT));
 	}
+
+	void step() override {
+		VoltageSequencer* module = getModule<VoltageSequencer>();
+		unsigned char page = module ? module->page : 0;
+		for (unsigned char p = 0; p < 8; p++) {
+			for (Widget* widget : pageWidgets[p]) widget->visible = (p == page);
+		}
+		ModuleWidget::step();
+	}
+
+	void appendContextMenu(Menu* menu) override {
+		VoltageSequencer* module = getModule<VoltageSequencer>();
+		menu->addChild(new MenuSeparator);
+		menu->addChild(createIndexPtrSubmenuItem("Stages", {"8", "16", "32", "64"}, &module->stageCount));
+		std::vector<std::string> pages;
+		for (unsigned char p = 0; p < (1 << module->stageCount); p++) pages.push_back("Stages " + std::to_string((p << 3) + 1) + "-" + std::to_string((p << 3) + 8));
+		menu->addChild(createIndexPtrSubmenuItem("Shown page", pages, &module->page));
+		menu->addChild(createBoolPtrMenuItem("Select input channels select pages", "", &module->selectPages));
+		appendCpuProfilerMenu(menu, module, module->cpuProfiler);
+	}
 };
 Model* modelVoltageSequencer = createModel<VoltageSequencer, VoltageSequencerWidget>("VoltageSequencer");
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef VOLTAGE_SEQUENCER_CORE_H
+#define VOLTAGE_SEQUENCER_CORE_H
+#include <rack.hpp>
+#include "../utils/lanes.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// Transposes a matrix of 8x8 bits (byte r, bit c becomes byte c, bit r) with three delta swaps
+inline uint64_t transposeBits(uint64_t x) {
+	uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+	return x ^ t ^ (t << 28);
+}
+
+// Playheads of VoltageSequencer, independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct VoltageSequencerCore {
+	typedef typename Lanes<T>::Mask Mask;
+	rack::dsp::TSchmittTrigger<T> resetTrig, presetTrig, directionTrig, vClockTrig, clock;
+	Mask direction = {};                        // Sequencer directions mask: false (to the right), true (to the left)
+	Mask vStage = {};                           // Sequencer vertical stages mask: false (Row A), true (Row B)
+	T stage = 0.f;                              // Sequencer stages
+	T aValues = 0.f, bValues = 0.f;             // Row A & B values of the current stages
+	T allGates = 0.f;                           // ALL GATES output
+
+	// Processes the trigger only in lanes where it is requested, the other lanes keep their previous state
+	Mask processMasked(rack::dsp::TSchmittTrigger<T>& trigger, T in, Mask mask) {
+		auto state = trigger.state;
+		Mask triggered = Mask(trigger.process(in, triggerThresholdLevel, triggerThresholdLevel) & mask);
+		trigger.state = ifelse(mask, trigger.state, state);
+		return triggered;
+	}
+
+	// Advances the playheads. Clock inputs are already scaled by their enable switches,
+	// selected tells whether manual or voltage stage select (to the preset stage) is active.
+	// Returns true if the stage, vertical stage or ALL GATES changed in any lane
+	// (Row A & B values then have to be gathered again).
+	bool process(T resetIn, T presetIn, T directionIn, T vClockIn, T clockIn, T holdIn, bool selected, unsigned char preset, float stages) {
+		T previousStage = stage, previousAllGates = allGates;
+		Mask previousVStage = vStage;
+		Mask selectedMask = Lanes<T>::mask(selected);
+		// Process incoming priority triggers
+		Mask reset = resetTrig.process(resetIn, triggerThresholdLevel, triggerThresholdLevel);
+		direction ^= directionTrig.process(directionIn, triggerThresholdLevel, triggerThresholdLevel);
+		vStage ^= vClockTrig.process(vClockIn, triggerThresholdLevel, triggerThresholdLevel);
+		// If no reset detected, check whether stage select or PRESET has been requested
+		Mask toPreset = selectedMask | processMasked(presetTrig, presetIn, Lanes<T>::invert(reset | selectedMask));
+		toPreset &= Lanes<T>::invert(reset);
+		// Otherwise, check if the CLOCK edge is detected and we are not HOLDing
+		Mask clocked = processMasked(clock, clockIn, Mask(Lanes<T>::invert(reset | toPreset) & (holdIn < triggerThresholdLevel)));
+		// Change sequencer state if any change was requested (and limit the value to 0 - (stages - 1) range)
+		T newStage = ifelse(toPreset, T(preset), stage + ifelse(direction, T(-1.f), T(1.f)));
+		newStage += ifelse(newStage < 0.f, T(stages), T(0.f)) - ifelse(newStage >= stages, T(stages), T(0.f));
+		stage = ifelse(reset, T(0.f), ifelse(Mask(toPreset | clocked), newStage, stage));
+		// ALL GATES is high if manual or voltage stage select was triggered
+		allGates = ifelse(Mask(selectedMask & Lanes<T>::invert(reset)), gateOn, gateOff);
+		return Lanes<T>::bits(Mask((stage != previousStage) | (allGates != previousAllGates) | Mask(vStage ^ previousVStage)));
+	}
+
+	// Gathers Row A & B values of the current stages (a and b hold the values of all stages)
+	void gather(const float* a, const float* b) {
+		aValues = Lanes<T>::gather(a, stage);
+		bValues = Lanes<T>::gather(b, stage);
+	}
+};
+#endif // VOLTAGE_SEQUENCER_CORE_H
@@ -0,0 +1,133 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef WINDOW_GENERATORS_H
+#define WINDOW_GENERATORS_H
+#include "../plugin.hpp"
+#include "WindowGeneratorsCore.hpp"
+
+struct WindowGenerators : Module {
+	enum ParamId {
+		ENUMS(P_POT, 5),
+		ENUMS(A_POT, 5),
+		SHAPE_PARAM,
+		BUT_PARAM,
+		PARAMS_LEN
+	};
+	enum InputId {
+		ENUMS(V_IN, 5),
+		GATE_INPUT,
+		TRIG_INPUT,
+		VALL_INPUT,
+		INPUTS_LEN
+	};
+	enum OutputId {
+		ENUMS(G_OUT, 5),
+		DADSR_OUTPUT,
+		AHDSR_OUTPUT,
+		DAHR_OUTPUT,
+		ADASR_OUTPUT,
+		G0_OUTPUT,
+		OUTPUTS_LEN
+	};
+	enum LightId {
+		LIGHTS_LEN
+	};
+
+	float envMax = 10.f;                // Maximum envelope voltage
+	unsigned char channels = 1;         // Number of polyphonic channels
+	std::unique_ptr<SimdKernel<WindowGenerators>> simdKernel;   // Envelope generators for the widest instruction set
+	ControlRate controlRate;            // Schedules knob-only computations
+	CpuProfiler cpuProfiler;            // Cost of process() (instrumented builds only)
+	ControlRateValue<> pots[5];         // T1-T4 and SUSTAIN knobs (SUSTAIN already limited if not modulated)
+	ControlRateValue<> attvs[5];        // T1-T4 and SUSTAIN CV attenuverters
+	ControlRateValue<> shapeValue;      // SHAPE knob
+	bool cycle = false;                 // Internal END to TRIGGER feedback (when TRIGGER is not connected)
+	unsigned char engine = 0;           // Requested envelope engine: 0 (slew), 1 (segments)
+	unsigned char activeEngine = 0;     // Envelope engine currently in use
+	float potNow[5] = {};               // Current values of pots and attvs, read by the kernel
+	float attvNow[5] = {};
+	float shapeNow = 0.f;               // Current value of shapeValue
+
+	WindowGenerators() {
+		config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+		std::string labels[5] = {"T1", "T2", "T3", "Sustain", "T4"};
+		for (unsigned char i = 0; i < 5; i++) {
+			std::string label = labels[i];
+			configOutput(i, label + " Gate");
+			configInput(i, label + " CV");
+			configParam(i + 5, -1.f, 1.f, 0.f, label + " CV Attenuverter");
+			if (i != 3) configParam(i, -6, 8.f, 1.f, label + " Time", "s", 0.5f, 0.5f);
+		}
+		configParam(P_POT + 3, 0.f, envMax, 0.5f * envMax, labels[3] + " Level", "V");
+		configParam(BUT_PARAM, 0.f, 1.f, 0.f, "Manual Gate");
+		configParam(SHAPE_PARAM, -1.f, 1.f, 0.f, "Shape (LOG-LIN-EXP)");
+		configInput(GATE_INPUT, "Gate");
+		configInput(TRIG_INPUT, "Trigger");
+		configInput(VALL_INPUT, "CV for all Tx parameters");
+		configOutput(DADSR_OUTPUT, "Delay-Attack-Decay-Sustain-Release");
+		configOutput(AHDSR_OUTPUT, "Attack-Hold-Decay-Sustain-Release");
+		configOutput(DAHR_OUTPUT, "Delay-Attack-Hold-Release");
+		configOutput(ADASR_OUTPUT, "Attack-Decay-Attack-Sustain-Release");
+		configOutput(G0_OUTPUT, "End Gate");
+		simdKernel.reset(createSimdKernel<WindowGenerators>());
+	}
+
+	// Switches the envelope engine, the envelopes continue from their current values
+	void applySettings() {
+		simdKernel->applySettings(*this);
+		activeEngine = engine;
+	}
+
+	json_t* dataToJson() override {
+		json_t* rootJ = json_object();
+		json_object_set_new(rootJ, "cycle", json_boolean(cycle));
+		json_object_set_new(rootJ, "engine", json_integer(engine));
+		return rootJ;
+	}
+
+	void dataFromJson(json_t* rootJ) override {
+		json_t* cycleJ = json_object_get(rootJ, "cycle");
+		if (cycleJ) cycle = json_boolean_value(cycleJ);
+		json_t* engineJ = json_object_get(rootJ, "engine");
+		if (engineJ) engine = clamp((int) json_integer_value(engineJ), 0, 1);
+	}
+
+	void process(const ProcessArgs& args) override {
+		CpuProfiler::Scope profile(cpuProfiler);
+		// Settings are changed from the UI thread, apply them here
+		if (engine != activeEngine) applySettings();
+		channels = 1;
+		for (unsigned char i = 0; i < INPUTS_LEN; i++) channels = std::max(channels, (unsigned char) inputs[i].getChannels());
+		if (controlRate.process()) {
+			for (unsigned char j = 0; j < 5; j++) {
+				// Without CV the value only depends on the knob (SUSTAIN level can be limited here)
+				bool modulated = inputs[V_IN + j].isConnected();
+				float pot = params[P_POT + j].getValue();
+				pots[j].setTarget(controlRate, (j == 3 && !modulated) ? clamp(pot, 0.f, envMax) : pot, modulated);
+				attvs[j].setTarget(controlRate, params[A_POT + j].getValue());
+			}
+			shapeValue.setTarget(controlRate, params[SHAPE_PARAM].getValue());
+		}
+		for (unsigned char j = 0; j < 5; j++) {
+			potNow[j] = pots[j].process();
+			attvNow[j] = attvs[j].process();
+		}
+		shapeNow = shapeValue.process();
+		simdKernel->process(*this, args);
+		for (unsigned char i = 0; i < OUTPUTS_LEN; i++) outputs[i].setChannels(channels);
+	}
+};
+
+#endif // WINDOW_GENERATORS_H
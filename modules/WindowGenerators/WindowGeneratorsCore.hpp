@@ -0,0 +1,215 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef WINDOW_GENERATORS_CORE_H
+#define WINDOW_GENERATORS_CORE_H
+#include <rack.hpp>
+#include "../utils/fast_math.hpp"
+#include "../utils/lanes.hpp"
+#include "../utils/voltage_helpers.hpp"
+
+// Four envelope generators of WindowGenerators sharing the stages, independent of Rack's engine.
+// T is the sample type (float or float_4), every lane is one polyphonic channel.
+template <typename T>
+struct WindowGeneratorsCore {
+	typedef typename Lanes<T>::Mask Mask;
+	float envMax = 10.f;                            // Maximum envelope voltage
+	rack::dsp::TSchmittTrigger<T> trig;             // Schmitt Trigger for processing trigger input
+	rack::dsp::TSchmittTrigger<T> gate;             // Schmitt Trigger for processing gate input (and manual gate)
+	// Envelope current stage
+	// Value | Stage
+	// ------|-------
+	// 0     | T1
+	// 1     | T2
+	// 2     | T3
+	// 3     | SUSTAIN
+	// 4     | T4
+	// 5     | END
+	T stage = 5.f;
+	T envTargets[4] = {};                           // Voltage targets for slew limiters
+	rack::dsp::TSlewLimiter<T> envs[4];             // Slew limiters acting as envelope generators
+	T envOuts[4] = {};                              // Current/last states of the envelope generators (DADSR, AHDSR, DAHR, ADASR)
+	T gates[6] = {};                                // Stage gates (T1-T4, SUSTAIN) and END gate
+	T riseVoltages[4] = {};                         // Time voltages the current slew rates were computed from
+	T fallVoltages[4] = {};
+	bool ratesCached = false;                       // Slew rates were computed at least once
+	// Segment engine state, every envelope moves along a precomputed segment towards its target
+	T remaining[4] = {};                            // Samples left to the end of the segment (<= 0 once the target is reached)
+	T positions[4] = {};                            // Position on the segment: envelope's value, or 2^(-shape * value) on curves
+	T steps[4] = {};                                // Position increments per sample
+	T segmentTargets[4] = {};                       // Targets and time voltages the segments were computed for
+	T segmentVoltages[4] = {};
+	float segmentShape = 0.f;                       // SHAPE the segments were computed with
+	bool segmentsValid = false;                     // Segments were computed with the current state of the envelopes
+
+	// Updates the stages based on global envelope value (ADASR)
+	// ADASR was chosen because the value is slewed always in timed stages
+	// (both DADSR and AHDSR have holding timed stage). This way we can
+	// always compare the value with the target and update the stage when it is reached.
+	T updateStage(Mask triggered, Mask gateHigh, Mask reached) {
+		Mask retrigger = triggered & (stage > 2.f);                         // Retrigger only if in SUSTAIN stage or later
+		Mask advance = ifelse(
+			stage == 3.f,
+			Lanes<T>::invert(gateHigh),                                     // Upgrade to RELEASE only when the gate is LOW
+			Mask((stage != 5.f) & reached)                                  // Otherwise, upgrade only if the target is reached
+		);                                                                  // (do not upgrade when RELEASE stage is over)
+		return ifelse(retrigger, T(0.f), stage + ifelse(advance, T(1.f), T(0.f)));
+	}
+
+	// Updates slew voltage targets based on the current stages
+	void updateTargets(T sus) {
+		Mask early = stage < 2.f;                                           // T1 or T2
+		T delayed = ifelse(stage == 1.f, T(envMax), T(0.f));
+		T held = ifelse(stage < 4.f, sus, T(0.f));                          // Always sustain level except for DAHR
+		envTargets[0] = ifelse(early, delayed, held);
+		envTargets[1] = ifelse(early, T(envMax), held);
+		envTargets[2] = ifelse(early, delayed, ifelse(stage == 2.f, T(envMax), T(0.f)));
+		envTargets[3] = ifelse(early, envMax - delayed, held);
+	}
+
+	// Processes trigger and gate inputs and moves to the next stage (reached marks lanes where ADASR is at its target),
+	// then updates the targets. Returns the lanes restarted by the internal END to TRIGGER feedback.
+	Mask advance(T trigIn, T gateIn, T sus, Mask reached, bool cycle) {
+		Mask triggered = trig.process(trigIn, triggerThresholdLevel, triggerThresholdLevel);
+		triggered = triggered | gate.process(gateIn, triggerThresholdLevel, triggerThresholdLevel);
+		stage = updateStage(triggered, gate.isHigh(), reached);
+		Mask restarted = Lanes<T>::mask(false);
+		if (cycle) {
+			restarted = (stage == 5.f);
+			stage = ifelse(restarted, T(0.f), stage);
+		}
+		updateTargets(sus);
+		return restarted;
+	}
+
+	// Picks time voltages of the current stages for each envelope
+	void selectTimes(const T* times, T* rises, T* falls) {
+		// Rise slew rate for slew limiters: {T2, T1, T2, T1 or T3}
+		rises[0] = times[1];
+		rises[1] = times[0];
+		rises[2] = times[1];
+		rises[3] = ifelse(stage > 1.f, times[2], times[0]);
+		// Fall slew rate for slew limiters: {T3 or T4, T3 or T4, T4, T2 or T4}
+		Mask inSustain = (stage > 2.f);
+		T threeOrFour = ifelse(inSustain, times[3], times[2]);
+		falls[0] = threeOrFour;
+		falls[1] = threeOrFour;
+		falls[2] = times[3];
+		falls[3] = ifelse(inSustain, times[3], times[1]);
+	}
+
+	void updateGates(Mask restarted) {
+		// Stage gates and END gate
+		for (unsigned char i = 0; i < 6; i++) gates[i] = ifelse(stage == i, gateOn, gateOff);
+		// END gate still marks the end of the cycle
+		gates[5] = ifelse(restarted, T(gateOn), gates[5]);
+	}
+
+	// Converts voltage values (time-based) to frequency, regular (2**V) * 2 * VoltagePeakToPeak
+	// The values passed here should already contain VC_ALL and scaled envelope's value (SHAPE)
+	T voltageToTime(T values) {
+		return 2.f * envMax * fastExp2(clamp(values, -6.f, 8.f));
+	}
+
+	// Runs the envelopes: times are T1-T4 voltages, sus is the (limited) SUSTAIN level,
+	// all is VC_ALL voltage and shape scales the envelope's value added to its own rates.
+	// When cycling, END retriggers the envelopes inside the core, in the same sample the release ends.
+	void process(float sampleTime, T trigIn, T gateIn, const T* times, T sus, T all, float shape, bool cycle = false) {
+		Mask restarted = advance(trigIn, gateIn, sus, envOuts[3] == envTargets[3], cycle);
+		T rises[4], falls[4];
+		selectTimes(times, rises, falls);
+		for (unsigned char i = 0; i < 4; i++) {
+			// VC_ALL and SHAPE (scaled envelope's value) affect both rates
+			T offset = all + shape * envOuts[i];
+			T rise = rises[i] + offset;
+			T fall = falls[i] + offset;
+			// Rates only change with the times, the stage or the envelope's value (if SHAPE is not zero),
+			// so in most samples (all of a segment when SHAPE is zero) the cached ones are still valid
+			if (!ratesCached || Lanes<T>::bits((rise != riseVoltages[i]) | (fall != fallVoltages[i]))) {
+				riseVoltages[i] = rise;
+				fallVoltages[i] = fall;
+				envs[i].setRiseFall(voltageToTime(rise), voltageToTime(fall));
+			}
+			// Slew
+			envOuts[i] = clamp(envs[i].process(sampleTime, envTargets[i]), 0.f, envMax);
+		}
+		ratesCached = true;
+		updateGates(restarted);
+	}
+
+	// Below this SHAPE segments are straight lines (the curves are numerically indistinguishable from them)
+	static bool curved(float shape) {
+		return std::fabs(shape) >= 1e-3f;
+	}
+
+	// Starts new segments (in the masked lanes) of envelope i from its current value towards its target.
+	// The rate is 2^(voltage + shape * value) like in the slew engine, so with SHAPE the position 2^(-shape * value)
+	// moves linearly in time and the segment's length is known in advance. It is limited to the lengths
+	// of straight segments at the slowest and fastest time, like the slew engine limits its rates.
+	void startSegment(unsigned char i, Mask lanes, float sampleTime, T voltage, float shape) {
+		T from = envOuts[i], to = envTargets[i];
+		T distance = rack::simd::abs(to - from);
+		T length = distance / (voltageToTime(voltage) * sampleTime);
+		T position = from, end = to;
+		if (curved(shape)) {
+			position = fastExp2(-shape * from);
+			end = fastExp2(-shape * to);
+			T curveLength = rack::simd::abs(end - position) / (std::fabs(shape) * (float) M_LN2 * voltageToTime(voltage) * sampleTime);
+			length = clamp(curveLength, distance / (voltageToTime(8.f) * sampleTime), distance / (voltageToTime(-6.f) * sampleTime));
+		}
+		remaining[i] = ifelse(lanes, length, remaining[i]);
+		positions[i] = ifelse(lanes, position, positions[i]);
+		steps[i] = ifelse(lanes, (end - position) / rack::simd::fmax(length, 1.f), steps[i]);
+		segmentTargets[i] = ifelse(lanes, to, segmentTargets[i]);
+		segmentVoltages[i] = ifelse(lanes, voltage, segmentVoltages[i]);
+	}
+
+	// Segment engine, same arguments and stages as process(). Stages end in the sample their segment ends
+	// (no comparison of slewed values) and envelopes at their targets are not computed at all.
+	void processSegments(float sampleTime, T trigIn, T gateIn, const T* times, T sus, T all, float shape, bool cycle = false) {
+		Mask restarted = advance(trigIn, gateIn, sus, remaining[3] <= 0.f, cycle);
+		T rises[4], falls[4];
+		selectTimes(times, rises, falls);
+		// All segments have to be recomputed when the curve changes
+		bool restart = !segmentsValid || shape != segmentShape;
+		segmentShape = shape;
+		segmentsValid = true;
+		bool curve = curved(shape);
+		for (unsigned char i = 0; i < 4; i++) {
+			T voltage = ifelse(envTargets[i] > envOuts[i], rises[i], falls[i]) + all;
+			// New segment when the target or the time of the current one changes (continues from the current value)
+			Mask changed = (envTargets[i] != segmentTargets[i]) | (voltage != segmentVoltages[i]);
+			if (restart) changed = Lanes<T>::mask(true);
+			if (Lanes<T>::bits(changed)) startSegment(i, changed, sampleTime, voltage, shape);
+			// Envelopes resting at their targets keep their values
+			if (!Lanes<T>::bits(remaining[i] > 0.f)) continue;
+			remaining[i] -= 1.f;
+			positions[i] += steps[i];
+			T value = curve ? -fastLog2(positions[i]) / shape : positions[i];
+			envOuts[i] = ifelse(remaining[i] <= 0.f, envTargets[i], clamp(value, 0.f, envMax));
+		}
+		updateGates(restarted);
+	}
+
+	// Continues from the current envelope values after the engine is switched
+	void carryStates() {
+		for (unsigned char i = 0; i < 4; i++) {
+			envs[i].out = envOuts[i];
+			// Stage progression needs to know which envelopes are at their targets before the segments are rebuilt
+			remaining[i] = ifelse(envOuts[i] == envTargets[i], T(0.f), T(1.f));
+		}
+		segmentsValid = false;
+	}
+};
+#endif // WINDOW_GENERATORS_CORE_H
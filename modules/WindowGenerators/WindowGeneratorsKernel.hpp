@@ -0,0 +1,59 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef WINDOW_GENERATORS_KERNEL_H
+#define WINDOW_GENERATORS_KERNEL_H
+// Included after WindowGenerators.hpp, inside an anonymous namespace (see utils/simd_kernel.hpp)
+
+// All channels of WindowGenerators processed with vector type T (float_4 or float_8)
+template <typename T>
+struct WindowGeneratorsKernel : SimdKernel<WindowGenerators> {
+	static constexpr unsigned char size = Lanes<T>::size;
+	WindowGeneratorsCore<T> cores[PORT_MAX_CHANNELS / size];    // Envelope generators, (size) channels per SIMD group
+
+	void applySettings(WindowGenerators& module) override {
+		for (unsigned char g = 0; g < PORT_MAX_CHANNELS / size; g++) cores[g].carryStates();
+	}
+
+	void process(WindowGenerators& module, const Module::ProcessArgs& args) override {
+		float manualGate = gateOn * module.params[WindowGenerators::BUT_PARAM].getValue();
+		const float* pot = module.potNow;
+		const float* attv = module.attvNow;
+		float shape = module.shapeNow;
+		bool cycle = module.cycle && !module.inputs[WindowGenerators::TRIG_INPUT].isConnected();
+		for (unsigned char c = 0; c < module.channels; c += size) {
+			unsigned char g = c / size;
+			// Calculate T1-T4 times, for now keep it in volts
+			T times[4];
+			for (unsigned char i = 0; i < 4; i++) {
+				unsigned char j = i + (i > 2);  // Skip SUSTAIN
+				times[i] = module.pots[j].modulated ? module.inputs[WindowGenerators::V_IN + j].getPolyVoltageSimd<T>(c) * attv[j] + pot[j] : T(pot[j]);
+			}
+			// Calculate and limit the SUSTAIN level
+			T sus = pot[3];
+			if (module.pots[3].modulated) sus = clamp(module.inputs[WindowGenerators::V_IN + 3].getPolyVoltageSimd<T>(c) * attv[3] + pot[3], 0.f, module.envMax);
+			T all = module.inputs[WindowGenerators::VALL_INPUT].getPolyVoltageSimd<T>(c);
+			WindowGeneratorsCore<T>& core = cores[g];
+			T trigIn = module.inputs[WindowGenerators::TRIG_INPUT].getPolyVoltageSimd<T>(c);
+			T gateIn = module.inputs[WindowGenerators::GATE_INPUT].getPolyVoltageSimd<T>(c) + manualGate;
+			if (module.activeEngine) core.processSegments(args.sampleTime, trigIn, gateIn, times, sus, all, shape, cycle);
+			else core.process(args.sampleTime, trigIn, gateIn, times, sus, all, shape, cycle);
+			for (unsigned char i = 0; i < 4; i++) module.outputs[WindowGenerators::DADSR_OUTPUT + i].setVoltageSimd(core.envOuts[i], c);
+			// Stage gates and END gate
+			for (unsigned char i = 0; i < 5; i++) module.outputs[WindowGenerators::G_OUT + i].setVoltageSimd(core.gates[i], c);
+			module.outputs[WindowGenerators::G0_OUTPUT].setVoltageSimd(core.gates[5], c);
+		}
+	}
+};
+#endif // WINDOW_GENERATORS_KERNEL_H
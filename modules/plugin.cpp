@@ -16,6 +16,8 @@
 Plugin* pluginInstance;
 void init(Plugin* p) {
 	pluginInstance = p;
+	// Kernels of the modules created from now on use the widest supported vector instructions
+	detectInstructionSet();
 	p->addModel(modelComparingCounter);
 	p->addModel(modelDigitalChaoticSystem);
 	p->addModel(modelDualIntegrator);
@@ -14,7 +14,17 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 #include <rack.hpp>
+#include "utils/control_rate.hpp"
+#include "utils/cpu_profiler.hpp"
+#include "utils/decimated_lights.hpp"
+#include "utils/fast_math.hpp"
+#include "utils/lanes.hpp"
+#include "utils/lookup_table.hpp"
+#include "utils/oversampler.hpp"
 #include "utils/panel_schema.hpp"
+#include "utils/polyblep.hpp"
+#include "utils/prng.hpp"
+#include "utils/simd_kernel.hpp"
 #include "utils/voltage_helpers.hpp"
 using namespace rack;
 extern Plugin* pluginInstance;
@@ -0,0 +1,82 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef CONTROL_RATE_H
+#define CONTROL_RATE_H
+#include <rack.hpp>
+
+#define CONTROL_RATE_DIVISION 16  // Default number of samples per control-rate tick
+
+// Schedules knob-only computations: they are evaluated once every (division) samples,
+// their results are linearly interpolated in between by ControlRateValue.
+struct ControlRate {
+	unsigned int division = CONTROL_RATE_DIVISION;
+	unsigned int clock = 0;                           // Samples left until the next tick
+	float smoothing = 1.f / CONTROL_RATE_DIVISION;    // Per-sample fraction of a control-rate period
+	bool started = false;                             // Whether the first tick has already happened
+	bool ramping = false;                             // Values ramp to new targets (otherwise they jump)
+
+	void setDivision(unsigned int division) {
+		this->division = std::max(1u, division);
+		smoothing = 1.f / this->division;
+		clock = std::min(clock, this->division - 1);
+	}
+	// Next sample evaluates the values again, they jump to their targets without ramping
+	void reset() {
+		clock = 0;
+		started = false;
+	}
+	// Returns true on samples when knob-only values should be evaluated
+	bool process() {
+		if (clock) {
+			clock--;
+			return false;
+		}
+		clock = division - 1;
+		ramping = started;
+		started = true;
+		return true;
+	}
+};
+
+// Value evaluated at control rate and linearly interpolated at audio rate.
+// Modules usually keep the fully derived value (e.g. a frequency) while the related CV inputs
+// are unconnected, and only the raw knob value otherwise (derivation then runs per sample).
+// The flag (modulated) tells which one is stored, the value jumps whenever it changes.
+template <typename T = float>
+struct ControlRateValue {
+	T value = 0.f;           // Interpolated value
+	T target = 0.f;          // Value reached at the next control-rate tick
+	T step = 0.f;            // Per-sample increment
+	bool modulated = false;  // Whether the related CV inputs are connected
+
+	void setTarget(const ControlRate& rate, T newTarget, bool modulated = false) {
+		if (rate.ramping && modulated == this->modulated) {
+			value = target;
+			step = (newTarget - target) * rate.smoothing;
+		}
+		else {
+			value = newTarget;
+			step = 0.f;
+		}
+		target = newTarget;
+		this->modulated = modulated;
+	}
+	T process() {
+		T current = value;
+		value += step;
+		return current;
+	}
+};
+#endif // CONTROL_RATE_H
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include "cpu_profiler.hpp"
+#ifdef CPU_PROFILER
+
+CpuProfiler::Stats CpuProfiler::stats() {
+	Stats stats;
+	// Ticks are converted with the time elapsed since recording started (exact for the steady clock)
+	uint64_t ticks = cpuTicks() - startTicks.load(std::memory_order_relaxed);
+	int64_t nanoseconds = steadyNanoseconds() - startNanoseconds.load(std::memory_order_relaxed);
+	if (ticks > 0 && nanoseconds > 0) stats.nanosecondsPerTick = (double) nanoseconds / ticks;
+	for (int i = 0; i < BUCKETS; i++) {
+		stats.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+		stats.calls += stats.buckets[i];
+	}
+	if (!stats.calls) return stats;
+	stats.mean = stats.nanosecondsPerTick * total.load(std::memory_order_relaxed) / count.load(std::memory_order_relaxed);
+	stats.maximum = stats.nanosecondsPerTick * maximum.load(std::memory_order_relaxed);
+	// Upper end of the bucket holding the 99th percentile
+	uint64_t below = 0;
+	for (int i = 0; i < BUCKETS; i++) {
+		below += stats.buckets[i];
+		if (100 * below >= 99 * stats.calls) {
+			stats.p99 = stats.nanosecondsPerTick * bucketStart(i + 1);
+			break;
+		}
+	}
+	return stats;
+}
+
+bool CpuProfiler::exportStats(std::string path, std::string name) {
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file) return false;
+	Stats s = stats();
+	std::fprintf(file, "# %s\n", name.c_str());
+	std::fprintf(file, "samples,mean_ns,p99_ns,max_ns,ns_per_tick\n");
+	std::fprintf(file, "%llu,%.3f,%.3f,%.3f,%.6f\n", (unsigned long long) s.calls, s.mean, s.p99, s.maximum, s.nanosecondsPerTick);
+	std::fprintf(file, "\nfrom_ns,to_ns,samples\n");
+	for (int i = 0; i < BUCKETS; i++) {
+		if (!s.buckets[i]) continue;
+		std::fprintf(file, "%.3f,%.3f,%llu\n", s.nanosecondsPerTick * bucketStart(i), s.nanosecondsPerTick * bucketStart(i + 1), (unsigned long long) s.buckets[i]);
+	}
+	std::fclose(file);
+	return true;
+}
+
+void appendCpuProfilerMenu(rack::ui::Menu* menu, rack::engine::Module* module, CpuProfiler& profiler) {
+	menu->addChild(new rack::ui::MenuSeparator);
+	menu->addChild(rack::createSubmenuItem("CPU usage (instrumented build)", "", [=, &profiler](rack::ui::Menu* menu) {
+		// The submenu is built when opened, so it shows the current statistics
+		CpuProfiler::Stats stats = profiler.stats();
+		menu->addChild(rack::createMenuLabel(rack::string::f("Samples: %llu", (unsigned long long) stats.calls)));
+		menu->addChild(rack::createMenuLabel(rack::string::f("Mean: %.1f ns/sample", stats.mean)));
+		menu->addChild(rack::createMenuLabel(rack::string::f("p99: %.1f ns/sample", stats.p99)));
+		menu->addChild(rack::createMenuLabel(rack::string::f("Max: %.1f ns/sample", stats.maximum)));
+		menu->addChild(rack::createMenuItem("Reset", "", [&profiler]() { profiler.reset(); }));
+		std::string name = rack::string::f("%s-%lld", module->model->slug.c_str(), (long long) module->id);
+		std::string path = rack::asset::user("PatchableDevices-cpu-" + name + ".csv");
+		menu->addChild(rack::createMenuItem("Export to " + path, "", [=, &profiler]() { profiler.exportStats(path, name); }));
+	}));
+}
+#endif // CPU_PROFILER
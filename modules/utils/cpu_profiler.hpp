@@ -0,0 +1,130 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+#include <rack.hpp>
+
+// Optional instrumentation of the modules' process() calls, built only with CPU_PROFILER defined
+// (make CPU_PROFILER=1). Every module keeps a CpuProfiler and times its process() with a Scope,
+// the context menu shows the statistics. Without the flag both are empty and compiled out.
+#ifdef CPU_PROFILER
+#include <atomic>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Time stamp counter (CPU cycles), steady clock nanoseconds on other architectures
+inline uint64_t cpuTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline int64_t steadyNanoseconds() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Histogram of process() durations in ticks. Written only by the audio thread (Rack never runs
+// one module on two threads at once), so plain relaxed loads and stores are enough, the UI thread
+// reads them without locking. Buckets are logarithmic with 8 steps per octave (12.5% resolution).
+struct CpuProfiler {
+	static constexpr int BUCKETS = 8 * 40;
+	std::atomic<uint64_t> buckets[BUCKETS];
+	std::atomic<uint64_t> count, total, maximum;        // Number of calls, sum and maximum of their ticks
+	std::atomic<uint64_t> startTicks;                   // Ticks and steady clock when recording (re)started,
+	std::atomic<int64_t> startNanoseconds;              // the UI converts ticks to nanoseconds with them
+	std::atomic<bool> resetRequested;                   // Set by the UI, the audio thread clears the statistics
+
+	struct Scope {
+		CpuProfiler& profiler;
+		uint64_t start;
+		Scope(CpuProfiler& profiler) : profiler(profiler), start(cpuTicks()) {}
+		~Scope() { profiler.record(cpuTicks() - start); }
+	};
+
+	// Summary of the recorded calls in nanoseconds
+	struct Stats {
+		uint64_t calls = 0;
+		double mean = 0.0, p99 = 0.0, maximum = 0.0;
+		double nanosecondsPerTick = 1.0;
+		uint64_t buckets[BUCKETS] = {};
+	};
+
+	CpuProfiler() {
+		for (int i = 0; i < BUCKETS; i++) buckets[i].store(0);
+		count.store(0);
+		total.store(0);
+		maximum.store(0);
+		startTicks.store(0);
+		startNanoseconds.store(0);
+		resetRequested.store(true);
+	}
+
+	// Values below 8 ticks have their own buckets, above that 8 buckets per power of two
+	static int bucket(uint64_t ticks) {
+		if (ticks < 8) return ticks;
+		int exponent = 63 - __builtin_clzll(ticks);
+		int i = (exponent - 2) * 8 + (int) ((ticks >> (exponent - 3)) & 0x07);
+		return (i < BUCKETS) ? i : BUCKETS - 1;
+	}
+
+	// Lowest number of ticks falling into a bucket
+	static uint64_t bucketStart(int i) {
+		if (i < 8) return i;
+		return (uint64_t) (8 + (i & 0x07)) << (i / 8 - 1);
+	}
+
+	static void increment(std::atomic<uint64_t>& value, uint64_t amount) {
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+
+	void record(uint64_t ticks) {
+		if (resetRequested.load(std::memory_order_relaxed)) clear();
+		increment(buckets[bucket(ticks)], 1);
+		increment(count, 1);
+		increment(total, ticks);
+		if (ticks > maximum.load(std::memory_order_relaxed)) maximum.store(ticks, std::memory_order_relaxed);
+	}
+
+	void clear() {
+		for (int i = 0; i < BUCKETS; i++) buckets[i].store(0, std::memory_order_relaxed);
+		count.store(0, std::memory_order_relaxed);
+		total.store(0, std::memory_order_relaxed);
+		maximum.store(0, std::memory_order_relaxed);
+		startNanoseconds.store(steadyNanoseconds(), std::memory_order_relaxed);
+		startTicks.store(cpuTicks(), std::memory_order_relaxed);
+		resetRequested.store(false, std::memory_order_release);
+	}
+
+	void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+	Stats stats();
+	bool exportStats(std::string path, std::string name);
+};
+
+void appendCpuProfilerMenu(rack::ui::Menu* menu, rack::engine::Module* module, CpuProfiler& profiler);
+#else
+struct CpuProfiler {
+	struct Scope {
+		Scope(CpuProfiler&) {}
+	};
+};
+
+inline void appendCpuProfilerMenu(rack::ui::Menu*, rack::engine::Module*, CpuProfiler&) {}
+#endif // CPU_PROFILER
+#endif // CPU_PROFILER_H
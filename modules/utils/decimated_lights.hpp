@@ -0,0 +1,46 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef DECIMATED_LIGHTS_H
+#define DECIMATED_LIGHTS_H
+#include <rack.hpp>
+
+#define LIGHT_DIVISION 64  // Default number of samples per light update
+
+// Brightness of (N) consecutive lights accumulated at audio rate and published (averaged)
+// once every (division) samples, so UI-only state is not written on every sample.
+// Averaging keeps short events (triggers, fast stage changes) visible.
+template <unsigned char N>
+struct DecimatedLights {
+	unsigned int division = LIGHT_DIVISION;
+	unsigned int clock = 0;  // Samples accumulated in the current period
+	float sums[N] = {};      // Accumulated brightness
+
+	void accumulate(unsigned char i, float brightness) { sums[i] += brightness; }
+	// Returns true once per (division) samples, when the lights should be published
+	bool process() {
+		if (++clock < division) return false;
+		clock = 0;
+		return true;
+	}
+	// Sets averaged brightness to the lights (starting from firstLightId) and starts a new period
+	void publish(std::vector<rack::engine::Light>& lights, int firstLightId) {
+		float scale = 1.f / division;
+		for (unsigned char i = 0; i < N; i++) {
+			lights[firstLightId + i].setBrightness(sums[i] * scale);
+			sums[i] = 0.f;
+		}
+	}
+};
+#endif // DECIMATED_LIGHTS_H
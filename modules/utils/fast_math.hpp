@@ -0,0 +1,96 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+#include <rack.hpp>
+#include "lanes.hpp"
+
+// Polynomial approximations of exponential, logarithm and sine functions computed natively on SIMD vectors
+// (float_4, float_8; no per-lane calls) and on float (the same operations on a single value).
+// Maximum errors measured against std:: (checked by headless/fastmath.cpp):
+//   fastExp2   relative error < 1.2e-7 over [-126, 126] (arguments are clamped to this range)
+//   fastExp10  relative error < 7e-7 over [-4.5, 4.5] (rounding of x * log2(10) dominates),
+//              covers NonlinearIntegrator's resonance arguments (about [-4.26, 0])
+//   fastLog2   absolute error < 1e-7 over [0.5, 2], < 1.1e-6 over [2^-20, 2^20] (rounding of the result dominates),
+//              positive normal arguments only
+//   fastSin    absolute error < 2e-7 over [-pi, pi], grows with |x| due to range reduction (< 6e-6 over [-100, 100])
+
+// 2^x: 2^round(x) is built from exponent bits, 2^fraction is a minimax polynomial (Cephes exp2f)
+template <typename T>
+inline T fastExp2(T x) {
+	typedef typename Lanes<T>::Int I;
+	x = clamp(x, -126.f, 126.f);
+	// Shifted to positive values, so truncation works as floor
+	I n = I(x + 126.5f) - 126;
+	T f = x - T(n);  // [-0.5, 0.5]
+	T p = 1.535336188319500e-4f;
+	p = p * f + 1.339887440266574e-3f;
+	p = p * f + 9.618437357674640e-3f;
+	p = p * f + 5.550332471162809e-2f;
+	p = p * f + 2.402264791363012e-1f;
+	p = p * f + 6.931472028550421e-1f;
+	p = p * f + 1.f;
+	return p * Lanes<T>::asFloat((n + 127) << 23);
+}
+
+// 10^x
+template <typename T>
+inline T fastExp10(T x) {
+	return fastExp2(x * 3.321928094887362f);
+}
+
+// log2(x): the exponent is taken from the bits, log of the mantissa (folded to [sqrt(0.5), sqrt(2)]) is a polynomial (Cephes logf)
+template <typename T>
+inline T fastLog2(T x) {
+	typedef typename Lanes<T>::Int I;
+	I bits = Lanes<T>::asInt(x);
+	T e = T((bits >> 23) - I(127));
+	T m = Lanes<T>::asFloat((bits & I(0x007fffff)) | I(0x3f800000));  // [1, 2)
+	auto upper = m > 1.414213562373095f;
+	m = ifelse(upper, 0.5f * m, m);
+	e += ifelse(upper, T(1.f), T(0.f));
+	T z = m - 1.f;
+	T z2 = z * z;
+	T p = 7.0376836292e-2f;
+	p = p * z - 1.1514610310e-1f;
+	p = p * z + 1.1676998740e-1f;
+	p = p * z - 1.2420140846e-1f;
+	p = p * z + 1.4249322787e-1f;
+	p = p * z - 1.6668057665e-1f;
+	p = p * z + 2.0000714765e-1f;
+	p = p * z - 2.4999993993e-1f;
+	p = p * z + 3.3333331174e-1f;
+	T ln = z + z * z2 * p - 0.5f * z2;
+	return ln * 1.442695040888963f + e;
+}
+
+// sin(x): reduced to [-pi, pi], folded to [-pi/2, pi/2], odd Taylor polynomial up to x^11
+template <typename T>
+inline T fastSin(T x) {
+	typedef typename Lanes<T>::Int I;
+	T turns = x * (float) (0.5 / M_PI);
+	turns += ifelse(turns < 0.f, T(-0.5f), T(0.5f));
+	x -= T(I(turns)) * (float) (2.0 * M_PI);
+	float halfPi = (float) (0.5 * M_PI);
+	x = ifelse(x > halfPi, T((float) M_PI - x), ifelse(x < -halfPi, T((float) -M_PI - x), x));
+	T x2 = x * x;
+	T p = -2.5052108e-8f;
+	p = p * x2 + 2.7557319e-6f;
+	p = p * x2 - 1.9841270e-4f;
+	p = p * x2 + 8.3333333e-3f;
+	p = p * x2 - 1.6666667e-1f;
+	return x + x * x2 * p;
+}
+#endif // FAST_MATH_H
@@ -0,0 +1,168 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef FLOAT_8_H
+#define FLOAT_8_H
+#ifndef __AVX2__
+#error "float_8.hpp is only for translation units compiled with -mavx2 (the modules' *Avx2.cpp files)"
+#endif
+#include <cstdint>
+#include <immintrin.h>
+
+// 8-wide AVX2 counterparts of Rack's float_4 and int32_4, with the subset of operations used by the DSP cores.
+// They live in rack::simd, so Rack's dsp templates (TSchmittTrigger, TSlewLimiter, ...) work with them unchanged.
+// Templates call simd::clamp() etc. qualified, so the overloads must be declared before Rack's headers:
+// include this header first.
+namespace rack {
+namespace simd {
+
+template <typename TYPE, int SIZE>
+struct Vector;
+
+template <>
+struct Vector<int32_t, 8>;
+
+template <>
+struct Vector<float, 8> {
+	using type = float;
+	constexpr static int size = 8;
+	union {
+		__m256 v;
+		float s[8];
+	};
+	Vector() = default;
+	Vector(__m256 v) : v(v) {}
+	Vector(float x) { v = _mm256_set1_ps(x); }
+	explicit Vector(Vector<int32_t, 8> a);
+	static Vector zero() { return Vector(_mm256_setzero_ps()); }
+	static Vector mask() { return Vector(_mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	static Vector load(const float* x) { return Vector(_mm256_loadu_ps(x)); }
+	void store(float* x) { _mm256_storeu_ps(x, v); }
+	static Vector cast(Vector<int32_t, 8> a);
+	float& operator[](int i) { return s[i]; }
+	const float& operator[](int i) const { return s[i]; }
+};
+
+template <>
+struct Vector<int32_t, 8> {
+	using type = int32_t;
+	constexpr static int size = 8;
+	union {
+		__m256i v;
+		int32_t s[8];
+	};
+	Vector() = default;
+	Vector(__m256i v) : v(v) {}
+	Vector(int32_t x) { v = _mm256_set1_epi32(x); }
+	Vector(int32_t x1, int32_t x2, int32_t x3, int32_t x4, int32_t x5, int32_t x6, int32_t x7, int32_t x8) { v = _mm256_setr_epi32(x1, x2, x3, x4, x5, x6, x7, x8); }
+	explicit Vector(Vector<float, 8> a) { v = _mm256_cvttps_epi32(a.v); }
+	static Vector zero() { return Vector(_mm256_setzero_si256()); }
+	static Vector mask() { return Vector(_mm256_set1_epi32(-1)); }
+	static Vector cast(Vector<float, 8> a) { return Vector(_mm256_castps_si256(a.v)); }
+	int32_t& operator[](int i) { return s[i]; }
+	const int32_t& operator[](int i) const { return s[i]; }
+};
+
+inline Vector<float, 8>::Vector(Vector<int32_t, 8> a) { v = _mm256_cvtepi32_ps(a.v); }
+inline Vector<float, 8> Vector<float, 8>::cast(Vector<int32_t, 8> a) { return Vector(_mm256_castsi256_ps(a.v)); }
+
+typedef Vector<float, 8> float_8;
+typedef Vector<int32_t, 8> int32_8;
+
+#define FLOAT_8_OPERATOR(op, expression) \
+	inline float_8 operator op(const float_8& a, const float_8& b) { return float_8(expression); } \
+	inline float_8 operator op(const float_8& a, float b) { return a op float_8(b); } \
+	inline float_8 operator op(float a, const float_8& b) { return float_8(a) op b; }
+FLOAT_8_OPERATOR(+, _mm256_add_ps(a.v, b.v))
+FLOAT_8_OPERATOR(-, _mm256_sub_ps(a.v, b.v))
+FLOAT_8_OPERATOR(*, _mm256_mul_ps(a.v, b.v))
+FLOAT_8_OPERATOR(/, _mm256_div_ps(a.v, b.v))
+FLOAT_8_OPERATOR(&, _mm256_and_ps(a.v, b.v))
+FLOAT_8_OPERATOR(|, _mm256_or_ps(a.v, b.v))
+FLOAT_8_OPERATOR(^, _mm256_xor_ps(a.v, b.v))
+FLOAT_8_OPERATOR(==, _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ))
+FLOAT_8_OPERATOR(>=, _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ))
+FLOAT_8_OPERATOR(>, _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ))
+FLOAT_8_OPERATOR(<=, _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ))
+FLOAT_8_OPERATOR(<, _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))
+FLOAT_8_OPERATOR(!=, _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ))
+#undef FLOAT_8_OPERATOR
+inline float_8& operator+=(float_8& a, const float_8& b) { return a = a + b; }
+inline float_8& operator-=(float_8& a, const float_8& b) { return a = a - b; }
+inline float_8& operator*=(float_8& a, const float_8& b) { return a = a * b; }
+inline float_8& operator/=(float_8& a, const float_8& b) { return a = a / b; }
+inline float_8& operator&=(float_8& a, const float_8& b) { return a = a & b; }
+inline float_8& operator|=(float_8& a, const float_8& b) { return a = a | b; }
+inline float_8& operator^=(float_8& a, const float_8& b) { return a = a ^ b; }
+inline float_8 operator-(const float_8& a) { return float_8(0.f) - a; }
+inline float_8 operator~(const float_8& a) { return a ^ float_8::mask(); }
+
+#define INT32_8_OPERATOR(op, expression) \
+	inline int32_8 operator op(const int32_8& a, const int32_8& b) { return int32_8(expression); } \
+	inline int32_8 operator op(const int32_8& a, int32_t b) { return a op int32_8(b); }
+INT32_8_OPERATOR(+, _mm256_add_epi32(a.v, b.v))
+INT32_8_OPERATOR(-, _mm256_sub_epi32(a.v, b.v))
+INT32_8_OPERATOR(*, _mm256_mullo_epi32(a.v, b.v))
+INT32_8_OPERATOR(&, _mm256_and_si256(a.v, b.v))
+INT32_8_OPERATOR(|, _mm256_or_si256(a.v, b.v))
+INT32_8_OPERATOR(^, _mm256_xor_si256(a.v, b.v))
+INT32_8_OPERATOR(==, _mm256_cmpeq_epi32(a.v, b.v))
+INT32_8_OPERATOR(>, _mm256_cmpgt_epi32(a.v, b.v))
+INT32_8_OPERATOR(<, _mm256_cmpgt_epi32(b.v, a.v))
+#undef INT32_8_OPERATOR
+inline int32_8 operator<<(const int32_8& a, int b) { return int32_8(_mm256_slli_epi32(a.v, b)); }
+inline int32_8 operator>>(const int32_8& a, int b) { return int32_8(_mm256_srai_epi32(a.v, b)); }
+inline int32_8& operator+=(int32_8& a, const int32_8& b) { return a = a + b; }
+inline int32_8& operator-=(int32_8& a, const int32_8& b) { return a = a - b; }
+inline int32_8& operator&=(int32_8& a, const int32_8& b) { return a = a & b; }
+inline int32_8& operator|=(int32_8& a, const int32_8& b) { return a = a | b; }
+inline int32_8& operator^=(int32_8& a, const int32_8& b) { return a = a ^ b; }
+inline int32_8 operator~(const int32_8& a) { return a ^ int32_8::mask(); }
+inline int32_8 operator-(const int32_8& a) { return int32_8(0) - a; }
+
+inline float_8 abs(float_8 a) { return float_8(_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v)); }
+inline float_8 fmax(float_8 a, float_8 b) { return float_8(_mm256_max_ps(a.v, b.v)); }
+inline float_8 fmin(float_8 a, float_8 b) { return float_8(_mm256_min_ps(a.v, b.v)); }
+inline float_8 clamp(float_8 x, float_8 a = 0.f, float_8 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_8 ifelse(float_8 mask, float_8 a, float_8 b) { return float_8(_mm256_blendv_ps(b.v, a.v, mask.v)); }
+inline int32_8 ifelse(int32_8 mask, int32_8 a, int32_8 b) { return int32_8(_mm256_blendv_epi8(b.v, a.v, mask.v)); }
+inline int movemask(float_8 a) { return _mm256_movemask_ps(a.v); }
+inline int movemask(int32_8 a) { return _mm256_movemask_ps(_mm256_castsi256_ps(a.v)); }
+
+} // namespace simd
+} // namespace rack
+
+#include <rack.hpp>
+#include "lanes.hpp"
+
+template <>
+struct Lanes<rack::simd::float_8> {
+	static constexpr int size = 8;
+	typedef rack::simd::float_8 Mask;
+	static Mask invert(Mask m) { return ~m; }
+	static int bits(Mask m) { return rack::simd::movemask(m); }
+	static rack::simd::float_8 fromBits(int bits) {
+		rack::simd::int32_8 laneBits = {1, 2, 4, 8, 16, 32, 64, 128};
+		return rack::simd::float_8::cast((rack::simd::int32_8(bits) & laneBits) == laneBits) & 1.f;
+	}
+	static Mask mask(bool b) { return b ? rack::simd::float_8::mask() : rack::simd::float_8::zero(); }
+	typedef rack::simd::int32_8 Int;
+	static Int asInt(rack::simd::float_8 x) { return Int::cast(x); }
+	static rack::simd::float_8 asFloat(Int i) { return rack::simd::float_8::cast(i); }
+	static float lane(rack::simd::float_8 x, int i) { return x[i]; }
+	static rack::simd::float_8 gather(const float* values, rack::simd::float_8 indices) {
+		return rack::simd::float_8(_mm256_i32gather_ps(values, _mm256_cvttps_epi32(indices.v), 4));
+	}
+};
+#endif // FLOAT_8_H
@@ -0,0 +1,65 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef LANES_H
+#define LANES_H
+#include <cstring>
+#include <rack.hpp>
+
+// Scalar and SIMD overloads visible together, so the cores can call them unqualified
+using rack::math::clamp;
+using rack::simd::clamp;
+using rack::simd::ifelse;
+
+// Lets the DSP cores be written once for scalar (float) and SIMD (float_4, float_8 in utils/float_8.hpp) sample types.
+// Comparisons give bool for float and lane masks for SIMD types, Mask names that type.
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<float> {
+	static constexpr int size = 1;
+	typedef bool Mask;
+	static Mask invert(Mask m) { return !m; }
+	static int bits(Mask m) { return m; }                             // Bit i set for every set lane i
+	static float fromBits(int bits) { return bits & 0x01; }           // 0 or 1 per lane
+	static Mask mask(bool b) { return b; }                            // All lanes set to b
+	typedef int32_t Int;                                              // Integer lanes, for bit manipulation of floats
+	static Int asInt(float x) { Int i; std::memcpy(&i, &x, sizeof(i)); return i; }   // Same bits reinterpreted
+	static float asFloat(Int i) { float x; std::memcpy(&x, &i, sizeof(x)); return x; }
+	static float lane(float x, int) { return x; }
+	static float gather(const float* values, float indices) { return values[(int) indices]; }
+};
+
+template <>
+struct Lanes<rack::simd::float_4> {
+	static constexpr int size = 4;
+	typedef rack::simd::float_4 Mask;
+	static Mask invert(Mask m) { return ~m; }
+	static int bits(Mask m) { return rack::simd::movemask(m); }
+	static rack::simd::float_4 fromBits(int bits) {
+		rack::simd::int32_4 laneBits = {1, 2, 4, 8};
+		return rack::simd::float_4::cast((rack::simd::int32_4(bits) & laneBits) == laneBits) & 1.f;
+	}
+	static Mask mask(bool b) { return b ? rack::simd::float_4::mask() : rack::simd::float_4::zero(); }
+	typedef rack::simd::int32_4 Int;
+	static Int asInt(rack::simd::float_4 x) { return Int::cast(x); }
+	static rack::simd::float_4 asFloat(Int i) { return rack::simd::float_4::cast(i); }
+	static float lane(rack::simd::float_4 x, int i) { return x[i]; }
+	// Looks up values[indices[i]] for every lane i
+	static rack::simd::float_4 gather(const float* values, rack::simd::float_4 indices) {
+		return rack::simd::float_4(values[(int) indices[0]], values[(int) indices[1]], values[(int) indices[2]], values[(int) indices[3]]);
+	}
+};
+#endif // LANES_H
@@ -0,0 +1,24 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include "lookup_table.hpp"
+void LookupTable::build(float xMin, float xMax, unsigned int pointsPerUnit, std::function<float(float)> f) {
+	this->xMin = xMin;
+	this->xMax = xMax;
+	scale = pointsPerUnit;
+	unsigned int size = (unsigned int)((xMax - xMin) * pointsPerUnit) + 1;
+	values.resize(size + 1);
+	for (unsigned int i = 0; i < size; i++) values[i] = f(xMin + i / scale);
+	values[size] = values[size - 1];
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+#include <functional>
+#include <vector>
+#include <rack.hpp>
+
+// Function sampled evenly over [xMin, xMax] and linearly interpolated between the points.
+// Used for replacing costly per-sample transcendental functions with a table read.
+struct LookupTable {
+	float xMin = 0.f, xMax = 0.f;   // Table range, arguments must be clamped to it
+	float scale = 0.f;              // Number of points per argument unit
+	std::vector<float> values;      // Sampled function, the last point is repeated (guard for interpolation)
+
+	void build(float xMin, float xMax, unsigned int pointsPerUnit, std::function<float(float)> f);
+
+	float process(float x) const {
+		float index = (x - xMin) * scale;
+		unsigned int i = index;
+		return values[i] + (index - i) * (values[i + 1] - values[i]);
+	}
+
+	// SIMD vectors (float_4, float_8)
+	template <typename T>
+	T process(T x) const {
+		typedef rack::simd::Vector<int32_t, T::size> I;
+		T index = (x - xMin) * scale;
+		I i = I(index);                 // Arguments are not negative, truncation is enough
+		T a, b;
+		for (unsigned char k = 0; k < T::size; k++) {
+			a[k] = values[i[k]];
+			b[k] = values[i[k] + 1];
+		}
+		return a + (index - T(i)) * (b - a);
+	}
+};
+#endif // LOOKUP_TABLE_H
@@ -0,0 +1,32 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#include "oversampler.hpp"
+void OversamplingKernel::setFactor(unsigned char factor) {
+	this->factor = factor;
+	length = factor * OVERSAMPLING_TAPS;
+	// Blackman windowed sinc, cutoff slightly below the original Nyquist frequency
+	float cutoff = 0.45f / factor;
+	float center = 0.5f * (length - 1);
+	float sum = 0.f;
+	for (unsigned char k = 0; k < length; k++) {
+		float x = k - center;
+		float sinc = (x == 0.f) ? 2.f * cutoff : std::sin(2.f * M_PI * cutoff * x) / (M_PI * x);
+		float window = 0.42f - 0.5f * std::cos(2.f * M_PI * k / (length - 1)) + 0.08f * std::cos(4.f * M_PI * k / (length - 1));
+		coefficients[k] = sinc * window;
+		sum += coefficients[k];
+	}
+	// Unity gain for DC
+	for (unsigned char k = 0; k < length; k++) coefficients[k] /= sum;
+}
@@ -0,0 +1,75 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+#include <rack.hpp>
+
+// Polyphase resampling for float or SIMD (float_4, float_8) signals with oversampling factor selectable at runtime (1, 2, 4 or 8).
+// The same low-pass kernel (windowed sinc) is used for both interpolation and decimation,
+// so it is kept separately and shared between all resamplers of a module.
+// Each resampler adds (OVERSAMPLING_TAPS / 2) samples of latency (in the original sample rate).
+static const unsigned char OVERSAMPLING_MAX_FACTOR = 8;
+static const unsigned char OVERSAMPLING_TAPS = 8;   // Taps per polyphase branch
+
+struct OversamplingKernel {
+	unsigned char factor = 1;
+	unsigned char length = OVERSAMPLING_TAPS;       // factor * OVERSAMPLING_TAPS
+	float coefficients[OVERSAMPLING_MAX_FACTOR * OVERSAMPLING_TAPS];
+
+	void setFactor(unsigned char factor);
+};
+
+// Converts one sample into (factor) samples
+template <typename T = rack::simd::float_4>
+struct PolyphaseUpsampler {
+	T history[OVERSAMPLING_TAPS] = {};
+
+	void reset() { for (unsigned char k = 0; k < OVERSAMPLING_TAPS; k++) history[k] = 0.f; }
+
+	void process(const OversamplingKernel& kernel, T in, T* out) {
+		for (unsigned char k = OVERSAMPLING_TAPS - 1; k > 0; k--) history[k] = history[k - 1];
+		history[0] = in;
+		// Branch p uses every (factor)th coefficient, the zeros inserted between the samples are skipped
+		for (unsigned char p = 0; p < kernel.factor; p++) {
+			T acc = 0.f;
+			for (unsigned char k = 0; k < OVERSAMPLING_TAPS; k++) acc += kernel.coefficients[k * kernel.factor + p] * history[k];
+			out[p] = kernel.factor * acc;
+		}
+	}
+};
+
+// Converts (factor) samples into one sample
+template <typename T = rack::simd::float_4>
+struct PolyphaseDecimator {
+	// Doubled ring buffer, so the last (length) samples are always available as a continuous block
+	T history[2 * OVERSAMPLING_MAX_FACTOR * OVERSAMPLING_TAPS] = {};
+	unsigned char position = 0;
+
+	void reset() {
+		for (unsigned char k = 0; k < 2 * OVERSAMPLING_MAX_FACTOR * OVERSAMPLING_TAPS; k++) history[k] = 0.f;
+		position = 0;
+	}
+
+	T process(const OversamplingKernel& kernel, const T* in) {
+		for (unsigned char p = 0; p < kernel.factor; p++) {
+			position = (position ? position : kernel.length) - 1;
+			history[position] = history[position + kernel.length] = in[p];
+		}
+		T acc = 0.f;
+		for (unsigned char k = 0; k < kernel.length; k++) acc += kernel.coefficients[k] * history[position + k];
+		return acc;
+	}
+};
+#endif // OVERSAMPLER_H
@@ -0,0 +1,37 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef POLYBLEP_H
+#define POLYBLEP_H
+#include <rack.hpp>
+
+// Polynomial corrections for band-limiting naive waveforms (PolyBLEP/PolyBLAMP).
+// The argument is the distance to the discontinuity in samples (negative before it),
+// corrections are non-zero only within one sample from the discontinuity.
+
+// Residual of a unit step (add it scaled by the step height)
+template <typename T>
+inline T polyBlep(T x) {
+	T before = 0.5f * (1.f + x) * (1.f + x);
+	T after = -0.5f * (1.f - x) * (1.f - x);
+	return rack::simd::ifelse(rack::simd::abs(x) < 1.f, rack::simd::ifelse(x < 0.f, before, after), T(0.f));
+}
+
+// Residual of a unit slope change per sample (add it scaled by the slope change per sample)
+template <typename T>
+inline T polyBlamp(T x) {
+	T y = 1.f - rack::simd::abs(x);
+	return rack::simd::ifelse(y > 0.f, (1.f / 6.f) * y * y * y, T(0.f));
+}
+#endif // POLYBLEP_H
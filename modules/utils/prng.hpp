@@ -0,0 +1,34 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef PRNG_H
+#define PRNG_H
+#include <rack.hpp>
+
+// Cheap, inlined pseudo-random number generator (xorshift32) owned by a module.
+// Its sequence depends only on the seed (unlike the global random::uniform()),
+// so once seeded, the module's outputs are reproducible bit-for-bit.
+struct Prng {
+	uint32_t state;
+	Prng() { seed(rack::random::u32()); }               // Every instance gets a different sequence by default
+	void seed(uint32_t s) { state = s ? s : 0x2545f491; }  // Zero is the only invalid state
+	uint32_t u32() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	float uniform() { return (u32() >> 8) * (1.f / 16777216.f); }  // [0, 1)
+};
+#endif // PRNG_H
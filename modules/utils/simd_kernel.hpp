@@ -0,0 +1,79 @@
+// Copyright (C) 2023 Jacek Lewański
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+#ifndef SIMD_KERNEL_H
+#define SIMD_KERNEL_H
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <rack.hpp>
+
+#define SIMD_KERNEL_ALIGNMENT 32
+
+// Vector instruction sets the modules' bulk DSP paths (kernels) are built for
+enum InstructionSet {
+	INSTRUCTION_SET_SSE,    // float_4, baseline of every build
+	INSTRUCTION_SET_AVX2    // float_8, x86-64 builds only (KERNELS_AVX2, see Makefile)
+};
+
+// The widest instruction set the CPU supports, detected once in init().
+// Kernels are chosen when a module is created, so changing it affects only new modules.
+extern InstructionSet instructionSet;
+void detectInstructionSet();
+
+// Runs all channels of a module with one vector type. The module keeps the knobs and settings,
+// the kernel owns the DSP cores and runs them over the module's ports.
+// Kernel templates (<Module>Kernel.hpp) are included inside an anonymous namespace by <Module>.cpp (float_4)
+// and by <Module>Avx2.cpp (float_8, compiled with -mavx2), which only export createSseKernel()
+// and createAvx2Kernel(). An inline function the AVX2 translation unit shares with the rest
+// of the plugin could be built there for AVX2 and picked by the linker for all callers, crashing
+// CPUs without AVX2. So kernels only read port voltages, plain module members and templates
+// instantiated on their vector type; control rate values, channel counts (setChannels)
+// and LEDs are handled by the module. `make -C headless avx2-symbols` checks the AVX2 objects.
+template <class TModule>
+struct SimdKernel {
+	virtual ~SimdKernel() {}
+	// Vectors of AVX2 kernels need 32 byte alignment, more than operator new guarantees before C++17
+	static void* operator new(std::size_t size) {
+		void* block = std::malloc(size + SIMD_KERNEL_ALIGNMENT + sizeof(void*));
+		if (!block) throw std::bad_alloc();
+		// The allocated block is kept just before the aligned pointer
+		uintptr_t aligned = ((uintptr_t) block + sizeof(void*) + SIMD_KERNEL_ALIGNMENT - 1) & ~(uintptr_t) (SIMD_KERNEL_ALIGNMENT - 1);
+		((void**) aligned)[-1] = block;
+		return (void*) aligned;
+	}
+	static void operator delete(void* p) {
+		if (p) std::free(((void**) p)[-1]);
+	}
+	virtual void process(TModule& module, const rack::engine::Module::ProcessArgs& args) = 0;
+	// Called when the module's settings the cores depend on are about to change
+	// (no default body: it would be shared code emitted by the AVX2 translation units)
+	virtual void applySettings(TModule& module) = 0;
+};
+
+// Defined by the module's translation units: <Module>.cpp and <Module>Avx2.cpp
+template <class TModule>
+SimdKernel<TModule>* createSseKernel();
+template <class TModule>
+SimdKernel<TModule>* createAvx2Kernel();
+
+// Creates the kernel for the widest instruction set detected at startup
+template <class TModule>
+SimdKernel<TModule>* createSimdKernel() {
+#ifdef KERNELS_AVX2
+	if (instructionSet == INSTRUCTION_SET_AVX2) return createAvx2Kernel<TModule>();
+#endif
+	return createSseKernel<TModule>();
+}
+#endif // SIMD_KERNEL_H